@@ -12,11 +12,20 @@ std::vector<std::string> SplitString(const std::string& str) {
     return result;
 }
 
+std::vector<std::string> SplitString(const std::string& str, char delimiter) {
+    std::vector<std::string> result;
+    std::istringstream strStream(str);
+    for (std::string token; std::getline(strStream, token, delimiter);) {
+        result.emplace_back(token);
+    }
+    return result;
+}
+
 bool MatchNoCase(const std::string& str1, const std::string& str2) {
     if (str1.size() != str2.size()) {
         return false;
     }
-    for (int i = 0; i < str1.size(); ++i) {
+    for (size_t i = 0; i < str1.size(); ++i) {
         if (tolower(str1[i]) != tolower(str2[i])) {
             return false;
         }
@@ -24,6 +33,42 @@ bool MatchNoCase(const std::string& str1, const std::string& str2) {
     return true;
 }
 
+bool StartWithNoCase(const std::string& str, const std::string& prefix) {
+    if (str.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (tolower(str[i]) != tolower(prefix[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AddPinSwapGroups(const std::string& spec) {
+    std::map<std::string, std::vector<std::vector<std::string> > >& pinSwapGroups = Config::GetInstance().pinSwapGroups;
+    std::istringstream parts(spec);
+    for (std::string part; std::getline(parts, part, ';');) {
+        const size_t colon = part.find(':');
+        if (colon == 0 || colon == std::string::npos) {
+            return false;
+        }
+        std::vector<std::string> pins;
+        std::istringstream pinStream(part.substr(colon + 1));
+        for (std::string pin; std::getline(pinStream, pin, ',');) {
+            if (pin.empty()) {
+                return false;
+            }
+            pins.emplace_back(pin);
+        }
+        if (pins.size() < 2) {
+            return false;
+        }
+        pinSwapGroups[part.substr(0, colon)].emplace_back(pins);
+    }
+    return true;
+}
+
 HASH_VALUE Rand() {
     srand(time(NULL));
     return rand();
@@ -31,7 +76,6 @@ HASH_VALUE Rand() {
 
 void SettingConfig(TestCase& testCase) {
     Config& config = Config::GetInstance();
-    Debug& debug = Debug::GetInstance();
 
     config.file1 = std::move(testCase.file1);
     config.topCell1 = std::move(testCase.topCell1);
@@ -43,18 +87,18 @@ void SettingConfig(TestCase& testCase) {
     config.autoMatch = testCase.autoMatch;
     config.multiThread = testCase.multiThread;
     config.tolerance = testCase.tolerance;
-
-    debug.executeWLShow = testCase.executeWLShow;
-    debug.iterateShow = testCase.iterateShow;
-    debug.cellShow = testCase.cellShow;
 }
 
 void OutputToFileOrTerminal() {
+    const std::string report = LogCollector::GetInstance().Flush();
+    if (report.empty()) {
+        return;
+    }
     std::string& outputFileName = Config::GetInstance().outputFileName;
     if (!outputFileName.empty()) {
         std::ofstream outFile(outputFileName);
-        outFile << OUT.str() << std::endl;
+        outFile << report << std::endl;
     } else {
-        std::cout << OUT.str() << std::endl;
+        std::cout << report << std::endl;
     }
 }
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <map>
 #include "express.h"
+#include "log.h"
 
 typedef std::string CELL_NAME;
 typedef std::string DEVICE_NAME;
@@ -29,6 +30,8 @@ constexpr READ_STATE ENDS_NO_MATCH_SUBCKT = 11; // no ".ends" match with ".ends"
 constexpr READ_STATE READ_MOSFET_ERROR = 21; // read mosfet error
 constexpr READ_STATE QUOTE_CANT_FIND_CELL = 31; // quote can't find cell
 constexpr READ_STATE QUOTE_PORT_NUMBER_ERROR = 42; // quote find cell but the number of ports is not matched.
+constexpr READ_STATE INCLUDE_FOUND = 51; // the file has .INCLUDE/.LIB, LibraryCache follows them before the quotes are bound
+constexpr READ_STATE INPUT_CORRUPT = 61; // a compressed file is cut off or damaged, or its format isn't built in
 constexpr READ_STATE HIERARCHY_LOOP = -128; // hierarchy structure has loop
 
 typedef int32_t PORT_INDEX;
@@ -38,10 +41,19 @@ typedef uint64_t HASH_VALUE;
 constexpr HASH_VALUE HASH_MOD_1 = 1000000007ll;
 constexpr HASH_VALUE HASH_MOD_2 = 1000000009ll;
 
+inline HASH_VALUE MixHash(HASH_VALUE seed, HASH_VALUE value) {
+    return (seed * HASH_MOD_1 + value) % HASH_MOD_2;
+}
+
 /* All the large numbers here are prime numbers. They were directly transplanted here. It would be best to use some other prime numbers */
 typedef HASH_VALUE DEVICE_TYPE;
 constexpr DEVICE_TYPE DEVICE_TYPE_MOSFET = 452375449ll;
 constexpr DEVICE_TYPE DEVICE_TYPE_QUOTE = 807303071ll;
+// composite devices built by gate recognition
+constexpr DEVICE_TYPE DEVICE_TYPE_GATE_INV = 130914761ll;
+constexpr DEVICE_TYPE DEVICE_TYPE_GATE_NAND2 = 233505451ll;
+constexpr DEVICE_TYPE DEVICE_TYPE_GATE_NOR2 = 702501511ll;
+constexpr DEVICE_TYPE DEVICE_TYPE_GATE_TG = 656541937ll;
 
 typedef HASH_VALUE PIN_MAGIC;
 constexpr PIN_MAGIC PIN_MAGIC_NO_DEFINE = 0;
@@ -49,6 +61,15 @@ constexpr PIN_MAGIC PIN_MAGIC_M_1 = 581880311ll;
 constexpr PIN_MAGIC PIN_MAGIC_M_2 = 772136249ll;
 constexpr PIN_MAGIC PIN_MAGIC_M_3 = PIN_MAGIC_M_1;
 constexpr PIN_MAGIC PIN_MAGIC_M_4 = 928917673ll;
+constexpr PIN_MAGIC PIN_MAGIC_G_IN = 450888299ll; // gate inputs are permutable
+constexpr PIN_MAGIC PIN_MAGIC_G_OUT = 263141213ll;
+constexpr PIN_MAGIC PIN_MAGIC_G_VDD = 661288541ll;
+constexpr PIN_MAGIC PIN_MAGIC_G_VSS = 296532331ll;
+constexpr PIN_MAGIC PIN_MAGIC_G_PBULK = 637049227ll;
+constexpr PIN_MAGIC PIN_MAGIC_G_NBULK = 315217499ll;
+constexpr PIN_MAGIC PIN_MAGIC_TG_SD = 321068711ll; // both channel ends of a transmission gate are permutable
+constexpr PIN_MAGIC PIN_MAGIC_TG_NGATE = 569909027ll;
+constexpr PIN_MAGIC PIN_MAGIC_TG_PGATE = 945410047ll;
 
 typedef uint8_t NETLIST_ID;
 constexpr NETLIST_ID NETLIST_1 = 0;
@@ -57,10 +78,12 @@ constexpr NETLIST_ID NETLIST_2 = 1;
 typedef int8_t COMPARE_NETLIST_RESULT;
 constexpr COMPARE_NETLIST_RESULT COMPARE_NETLIST_TRUE = 1;
 constexpr COMPARE_NETLIST_RESULT COMPARE_NETLIST_FALSE = 0;
+constexpr COMPARE_NETLIST_RESULT COMPARE_NETLIST_INCONCLUSIVE = -1; // OutOfCoreCompare gave up on symmetric classes
 
 typedef int8_t COMPARE_CELL_RESULT;
 constexpr COMPARE_CELL_RESULT COMPARE_CELL_TRUE = 1;
 constexpr COMPARE_CELL_RESULT COMPARE_CELL_FALSE = 0;
+constexpr COMPARE_CELL_RESULT COMPARE_CELL_CANCELLED = -1; // stopped by a cancel token, no verdict
 
 typedef int32_t ITERATE_STATUS; // >0  automorphism
 constexpr ITERATE_STATUS ITERATE_RESULT_FALSE = -1;
@@ -70,70 +93,73 @@ constexpr ITERATE_STATUS ITERATE_RIGHT_END = 0;
 typedef int32_t AUTOMORPHISM_GROUPS;
 // <0 return ITERATE_RESULT_FALSE
 
-static std::ostringstream OUT;
-void OutputToFileOrTerminal();
+void OutputToFileOrTerminal(); // flush the OUT pipeline of all threads
 
-static std::map<DEVICE_TYPE, std::vector<PIN_MAGIC> > pinMagicTable = {
-    {DEVICE_TYPE_MOSFET, {PIN_MAGIC_M_1, PIN_MAGIC_M_2, PIN_MAGIC_M_3, PIN_MAGIC_M_4}}
+inline std::map<DEVICE_TYPE, std::vector<PIN_MAGIC> > pinMagicTable = { // shared by all translation units
+    {DEVICE_TYPE_MOSFET, {PIN_MAGIC_M_1, PIN_MAGIC_M_2, PIN_MAGIC_M_3, PIN_MAGIC_M_4}},
+    {DEVICE_TYPE_GATE_INV, {PIN_MAGIC_G_IN, PIN_MAGIC_G_OUT, PIN_MAGIC_G_VDD, PIN_MAGIC_G_VSS, PIN_MAGIC_G_PBULK, PIN_MAGIC_G_NBULK}},
+    {DEVICE_TYPE_GATE_NAND2, {PIN_MAGIC_G_IN, PIN_MAGIC_G_IN, PIN_MAGIC_G_OUT, PIN_MAGIC_G_VDD, PIN_MAGIC_G_VSS, PIN_MAGIC_G_PBULK, PIN_MAGIC_G_NBULK}},
+    {DEVICE_TYPE_GATE_NOR2, {PIN_MAGIC_G_IN, PIN_MAGIC_G_IN, PIN_MAGIC_G_OUT, PIN_MAGIC_G_VDD, PIN_MAGIC_G_VSS, PIN_MAGIC_G_PBULK, PIN_MAGIC_G_NBULK}},
+    {DEVICE_TYPE_GATE_TG, {PIN_MAGIC_TG_SD, PIN_MAGIC_TG_SD, PIN_MAGIC_TG_NGATE, PIN_MAGIC_TG_PGATE, PIN_MAGIC_G_PBULK, PIN_MAGIC_G_NBULK}}
 };
 
 static std::map<PIN_MAGIC, std::string> pinNameTable = {
     {PIN_MAGIC_NO_DEFINE, {"pending quote"}},
-    {PIN_MAGIC_M_1, "M_pin1/3"}, {PIN_MAGIC_M_2, "M_pin2"}, {PIN_MAGIC_M_3, "M_pin1/3"}, {PIN_MAGIC_M_4, "M_pin4"}
+    {PIN_MAGIC_M_1, "M_pin1/3"}, {PIN_MAGIC_M_2, "M_pin2"}, {PIN_MAGIC_M_3, "M_pin1/3"}, {PIN_MAGIC_M_4, "M_pin4"},
+    {PIN_MAGIC_G_IN, "G_in"}, {PIN_MAGIC_G_OUT, "G_out"}, {PIN_MAGIC_G_VDD, "G_vdd"}, {PIN_MAGIC_G_VSS, "G_vss"},
+    {PIN_MAGIC_G_PBULK, "G_pbulk"}, {PIN_MAGIC_G_NBULK, "G_nbulk"},
+    {PIN_MAGIC_TG_SD, "TG_sd"}, {PIN_MAGIC_TG_NGATE, "TG_ngate"}, {PIN_MAGIC_TG_PGATE, "TG_pgate"}
 };
 
+constexpr PIN_MAGIC PIN_MAGIC_DECLARED_GROUP = 593675231ll; // mixed with the group index of declared swappable ports
+
+// "NAND2:A,B;nch:1,3" -> Config::pinSwapGroups, one group per ';' part, false if some part is malformed
+bool AddPinSwapGroups(const std::string& spec);
+
 inline std::string GetPinName(PIN_MAGIC pinMagic) {
     return !pinNameTable[pinMagic].empty()? pinNameTable[pinMagic]: std::to_string(pinMagic);
 }
 
 std::vector<std::string> SplitString(const std::string& str);
+std::vector<std::string> SplitString(const std::string& str, char delimiter); // empty parts are kept
 
 bool MatchNoCase(const std::string& str1, const std::string& str2);
+bool StartWithNoCase(const std::string& str, const std::string& prefix);
 
 struct TestCase {
     // config
     std::string file1; std::string topCell1; std::string file2; std::string topCell2; std::string outputFileName;
     bool caseInsensitive; bool hier; bool autoMatch; bool multiThread; double tolerance;
-
-    // debug
-    bool executeWLShow = 1; bool iterateShow = 0; bool cellShow = 0;
 };
 
 static TestCase testCase[] = {
     { // 0
         "hier1.spice", "", "hier2.spice", "", "",
-        false, true, false, false, 0.0,
-        true, true, false
+        false, true, false, false, 0.0
     },
     { // 1
         "layout.sp", "RAS1024X16", "layout2.sp", "RAS1024X16", "case1_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     },
     { // 2
         "layout.sp", "RAS1024X16", "layout2.sp", "RAS1024X16", "case2_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     },
     { // 3
         "layout.sp", "SOP_DC_X128Y8_620", "layout2.sp", "SOP_DC_X128Y8_620", "case3_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     },
     { // 4
         "layout.sp", "Logic_leafcell_X128Y8_VHS", "layout2.sp", "Logic_leafcell_X128Y8_VHS", "case4_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     },
     { // 5
         "layout.sp", "LEAF_XDEC4_VHSSRAM", "layout2.sp", "LEAF_XDEC4_VHSSRAM", "case5_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     },
     { // 6
         "layout.sp", "Logic_leafcell_X128Y8_VHS", "layout2.sp", "Logic_leafcell_X128Y8_VHS", "case6_res",
-        false, true, false, false, 0.0,
-        true, false, false
+        false, true, false, false, 0.0
     }
 };
 
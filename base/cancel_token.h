@@ -0,0 +1,16 @@
+#pragma once
+
+#include <atomic>
+
+// shared stop flag polled by long running loops, cancel is one way
+class CancelToken {
+    private:
+        std::atomic<bool> _cancelled{false};
+    public:
+        void Cancel() {
+            _cancelled.store(true, std::memory_order_relaxed);
+        }
+        bool IsCancelled() const {
+            return _cancelled.load(std::memory_order_relaxed);
+        }
+};
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include "log.h"
+
+LogCollector::LogCollector() : _head(&_stub), _tail(&_stub) {}
+
+LogCollector::~LogCollector() {
+    StopWriter();
+    while (LogChunk* chunk = Pop()) {
+        delete chunk;
+    }
+}
+
+LogCollector& LogCollector::GetInstance() {
+    static LogCollector instance;
+    return instance;
+}
+
+uint64_t LogCollector::NextSequence() {
+    return _sequence.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LogCollector::Push(std::unique_ptr<LogChunk> chunk) {
+    if (!_writerRunning.load(std::memory_order_acquire)) {
+        StartWriter();
+    }
+
+    LogChunk* node = chunk.release();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    LogChunk* prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+
+    _pushed.fetch_add(1, std::memory_order_release);
+    _pushed.notify_one();
+}
+
+LogChunk* LogCollector::Pop() {
+    LogChunk* tail = _tail;
+    LogChunk* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &_stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        _tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    if (tail != _head.load(std::memory_order_acquire)) {
+        return nullptr; // a producer is between exchange and link, the chunk is picked up next time
+    }
+    _stub.next.store(nullptr, std::memory_order_relaxed);
+    LogChunk* prev = _head.exchange(&_stub, std::memory_order_acq_rel);
+    prev->next.store(&_stub, std::memory_order_release);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void LogCollector::Drain() {
+    while (LogChunk* chunk = Pop()) {
+        _chunks.emplace_back(chunk);
+    }
+}
+
+void LogCollector::StartWriter() {
+    std::lock_guard<std::mutex> lock(_writerMutex);
+    if (_writerRunning) {
+        return;
+    }
+    _stop = false;
+    _writer = std::thread(&LogCollector::WriterLoop, this);
+    _writerRunning = true;
+}
+
+void LogCollector::WriterLoop() {
+    uint64_t seen = 0;
+    while (!_stop.load(std::memory_order_acquire)) {
+        _pushed.wait(seen, std::memory_order_acquire);
+        seen = _pushed.load(std::memory_order_acquire);
+        Drain();
+    }
+    Drain();
+}
+
+void LogCollector::StopWriter() {
+    std::lock_guard<std::mutex> lock(_writerMutex);
+    if (_writer.joinable()) {
+        _stop = true;
+        _pushed.fetch_add(1, std::memory_order_release);
+        _pushed.notify_one();
+        _writer.join();
+    }
+    _writerRunning = false;
+}
+
+std::string LogCollector::Flush() {
+    OUT.Commit();
+
+    // the writer is joined, so this thread is the only consumer until the next Push starts it again
+    StopWriter();
+    Drain();
+
+    std::stable_sort(_chunks.begin(), _chunks.end(), [](const std::unique_ptr<LogChunk>& a, const std::unique_ptr<LogChunk>& b) {
+        if (a->orderKey != b->orderKey) {
+            return a->orderKey < b->orderKey;
+        }
+        return a->sequence < b->sequence;
+    });
+
+    std::string report;
+    for (const std::unique_ptr<LogChunk>& chunk : _chunks) {
+        report += chunk->text;
+    }
+    _chunks.clear();
+    return report;
+}
+
+LogBuffer::~LogBuffer() {
+    Commit();
+}
+
+void LogBuffer::Commit() {
+    std::string text = _stream.str();
+    if (text.empty()) {
+        return;
+    }
+    _stream.str("");
+
+    std::unique_ptr<LogChunk> chunk = std::make_unique<LogChunk>();
+    chunk->text = std::move(text);
+    chunk->orderKey = _orderKey;
+    chunk->sequence = LogCollector::GetInstance().NextSequence();
+    LogCollector::GetInstance().Push(std::move(chunk));
+}
+
+void LogBuffer::SetOrderKey(const std::string& orderKey) {
+    Commit();
+    _orderKey = orderKey;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Report output. Every thread formats into its own LogBuffer (OUT), finished lines are handed
+// to LogCollector through a lock-free MPSC queue and a background writer collects them.
+// Flush sorts the collected chunks by order key, so the report does not depend on thread timing.
+struct LogChunk {
+    std::string text;
+    std::string orderKey; // e.g. the cell pair being compared, "" sorts first
+    uint64_t sequence; // global commit order, ties of one key keep the order of their thread
+    std::atomic<LogChunk*> next{nullptr};
+};
+
+class LogCollector {
+    private:
+        // Vyukov intrusive MPSC queue, producers only do one exchange
+        std::atomic<LogChunk*> _head;
+        LogChunk* _tail;
+        LogChunk _stub;
+
+        std::atomic<uint64_t> _pushed{0};
+        std::atomic<bool> _stop{false};
+        std::atomic<bool> _writerRunning{false};
+        std::thread _writer;
+        std::mutex _writerMutex; // only taken to start or stop the writer, never per chunk
+        std::vector<std::unique_ptr<LogChunk> > _chunks; // owned by the writer until Flush joins it
+        std::atomic<uint64_t> _sequence{0};
+    private:
+        LogCollector();
+        LogChunk* Pop(); // single consumer
+        void Drain();
+        void StartWriter();
+        void WriterLoop();
+        void StopWriter();
+    public:
+        ~LogCollector();
+        static LogCollector& GetInstance();
+
+        uint64_t NextSequence();
+        void Push(std::unique_ptr<LogChunk> chunk);
+        std::string Flush(); // commit the calling thread, stop the writer, return the ordered report
+};
+
+class LogBuffer {
+    private:
+        std::ostringstream _stream;
+        std::string _orderKey;
+        static constexpr size_t CHUNK_SIZE = 4096;
+    public:
+        LogBuffer() = default;
+        LogBuffer(const LogBuffer&) = delete;
+        LogBuffer& operator= (const LogBuffer&) = delete;
+        ~LogBuffer();
+
+        void Commit(); // hand the pending text to the collector
+        void SetOrderKey(const std::string& orderKey);
+        const std::string& GetOrderKey() const {
+            return _orderKey;
+        }
+
+        template <typename T>
+        LogBuffer& operator<< (const T& value) {
+            _stream << value;
+            return *this;
+        }
+        LogBuffer& operator<< (std::ostream& (*manipulator)(std::ostream&)) {
+            _stream << manipulator;
+            if (manipulator == static_cast<std::ostream& (*)(std::ostream&)>(std::endl) || _stream.tellp() >= static_cast<std::streamoff>(CHUNK_SIZE)) {
+                Commit();
+            }
+            return *this;
+        }
+};
+
+inline thread_local LogBuffer OUT; // replaces the per translation unit ostringstream
+
+// set at a scheduling point (a cell pair, a candidate, a batch group), the previous key is restored at scope exit
+class ScopedOrderKey {
+    private:
+        std::string _previous;
+    public:
+        explicit ScopedOrderKey(const std::string& orderKey) : _previous(OUT.GetOrderKey()) {
+            OUT.SetOrderKey(orderKey);
+        }
+        ScopedOrderKey(const ScopedOrderKey&) = delete;
+        ScopedOrderKey& operator= (const ScopedOrderKey&) = delete;
+        ~ScopedOrderKey() {
+            OUT.SetOrderKey(_previous);
+        }
+};
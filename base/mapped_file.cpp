@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+MappedFile::MappedFile(const std::string& directory) {
+    static std::atomic<uint32_t> fileId{0};
+    _path = directory + "/lvs_scratch_" + std::to_string(getpid()) + "_" + std::to_string(fileId++);
+    _fd = open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (_fd >= 0) {
+        unlink(_path.c_str()); // the space is freed with the last descriptor, even after a crash
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        munmap(_data, _capacity);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool MappedFile::IsOpen() const {
+    return _fd >= 0;
+}
+
+size_t MappedFile::GetSize() const {
+    return _size;
+}
+
+bool MappedFile::Reserve(size_t capacity) {
+    if (_fd < 0) {
+        return false;
+    }
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    capacity = std::max((capacity + pageSize - 1) / pageSize * pageSize, pageSize);
+    if (capacity <= _capacity) {
+        return true;
+    }
+    if (ftruncate(_fd, capacity) != 0) {
+        return false;
+    }
+    void* data = _data == nullptr ? mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0)
+        : mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    _data = static_cast<char*>(data);
+    _capacity = capacity;
+    return true;
+}
+
+bool MappedFile::Resize(size_t size) {
+    if (size > _capacity && !Reserve(size)) {
+        return false;
+    }
+    _size = size;
+    return true;
+}
+
+void MappedFile::Release(size_t begin, size_t end) {
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    // shared file pages are never lost by a release, a later access faults them in again
+    begin = begin / pageSize * pageSize;
+    end = std::min((end + pageSize - 1) / pageSize * pageSize, _capacity);
+    if (_data != nullptr && begin < end) {
+        madvise(_data + begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+void MappedFile::ReleaseAll() {
+    Release(0, _capacity);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Growable scratch file mapped into memory, removed when destroyed. Pages that are done with can be
+// released with Release, they go back to the page cache and no longer count against the resident set.
+class MappedFile {
+    private:
+        std::string _path;
+        int _fd{-1};
+        char* _data{nullptr};
+        size_t _size{0}; // bytes written
+        size_t _capacity{0}; // bytes mapped
+    private:
+        bool Reserve(size_t capacity);
+    public:
+        explicit MappedFile(const std::string& directory);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+        ~MappedFile();
+
+        bool IsOpen() const;
+        size_t GetSize() const;
+        bool Resize(size_t size); // zero filled when growing
+
+        template <typename T>
+        bool Append(const T& value) {
+            if (_size + sizeof(T) > _capacity && !Reserve(std::max(_capacity * 2, _size + sizeof(T)))) {
+                return false;
+            }
+            std::memcpy(_data + _size, &value, sizeof(T));
+            _size += sizeof(T);
+            return true;
+        }
+
+        template <typename T>
+        T* As() const {
+            return reinterpret_cast<T*>(_data);
+        }
+
+        void Release(size_t begin, size_t end); // byte range, widened to whole pages
+        void ReleaseAll();
+};
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include "profile.h"
+
+static std::string EscapeJson(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            result += c;
+        }
+    }
+    return result;
+}
+
+Profile::Profile() : _start(std::chrono::steady_clock::now()) {}
+
+Profile& Profile::GetInstance() {
+    static Profile instance;
+    return instance;
+}
+
+void Profile::SetEnabled(bool enabled) {
+    _enabled = enabled;
+}
+
+bool Profile::IsEnabled() const {
+    return _enabled;
+}
+
+int64_t Profile::Now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+Profile::ThreadBuffer& Profile::GetThreadBuffer() {
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+    if (threadBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(_buffersMutex);
+        _buffers.emplace_back(std::make_unique<ThreadBuffer>());
+        threadBuffer = _buffers.back().get();
+        threadBuffer->threadId = _buffers.size();
+    }
+    return *threadBuffer;
+}
+
+void Profile::Count(const std::string& cell, const char* counter, int64_t value) {
+    if (!_enabled) {
+        return;
+    }
+    GetThreadBuffer().counters[cell][counter] += value;
+}
+
+int64_t Profile::GetTotalTime(const std::string& name) {
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    int64_t total = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+        for (const Event& event : buffer->events) {
+            if (name == event.name) {
+                total += event.duration;
+            }
+        }
+    }
+    return total;
+}
+
+void Profile::Clear() {
+    // buffers stay registered to their threads
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+        buffer->events.clear();
+        buffer->counters.clear();
+    }
+}
+
+bool Profile::ExportChromeTrace(const std::string& fileName) {
+    std::ofstream outFile(fileName);
+    if (!outFile.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    outFile << "{\"traceEvents\":[";
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+        outFile << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << (buffer->threadId == 1 ? "main" : "worker " + std::to_string(buffer->threadId)) << "\"}}";
+        first = false;
+        for (const Event& event : buffer->events) {
+            outFile << ",\n{\"name\":\"" << EscapeJson(event.name) << "\",\"cat\":\"lvs\",\"ph\":\"X\",\"ts\":" << event.start
+                    << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":" << buffer->threadId;
+            if (!event.cell.empty()) {
+                outFile << ",\"args\":{\"cell\":\"" << EscapeJson(event.cell) << "\"}";
+            }
+            outFile << "}";
+        }
+    }
+    outFile << "\n]}" << std::endl;
+    return true;
+}
+
+bool Profile::ExportCellCsv(const std::string& fileName) {
+    std::ofstream outFile(fileName);
+    if (!outFile.is_open()) {
+        return false;
+    }
+
+    struct CellRecord {
+        int64_t time = 0;
+        int64_t calls = 0;
+        std::map<std::string, int64_t> counters;
+    };
+    std::map<std::string, CellRecord> records;
+    std::set<std::string> counterNames;
+
+    {
+        std::lock_guard<std::mutex> lock(_buffersMutex);
+        for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+            for (const Event& event : buffer->events) {
+                if (!event.cell.empty()) {
+                    records[event.cell].time += event.duration;
+                    ++records[event.cell].calls;
+                }
+            }
+            for (const auto& it : buffer->counters) {
+                for (const auto& counter : it.second) {
+                    records[it.first].counters[counter.first] += counter.second;
+                    counterNames.insert(counter.first);
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, CellRecord> > sortedRecords(records.begin(), records.end());
+    std::sort(sortedRecords.begin(), sortedRecords.end(), [](const auto& a, const auto& b) {
+        return a.second.time > b.second.time;
+    });
+
+    outFile << "cell,time_us,calls";
+    for (const std::string& counterName : counterNames) {
+        outFile << "," << counterName;
+    }
+    outFile << "\n";
+    for (const auto& [cell, record] : sortedRecords) {
+        outFile << cell << "," << record.time << "," << record.calls;
+        for (const std::string& counterName : counterNames) {
+            const auto it = record.counters.find(counterName);
+            outFile << "," << (it == record.counters.end() ? 0 : it->second);
+        }
+        outFile << "\n";
+    }
+    return true;
+}
+
+ScopedTimer::ScopedTimer(const char* name, const std::string& cell) : _name(name), _start(0) {
+    Profile& profile = Profile::GetInstance();
+    _enabled = profile.IsEnabled();
+    if (_enabled) {
+        _cell = cell;
+        _start = profile.Now();
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!_enabled) {
+        return;
+    }
+    Profile& profile = Profile::GetInstance();
+    const int64_t end = profile.Now();
+    profile.GetThreadBuffer().events.emplace_back(Profile::Event{_name, std::move(_cell), _start, end - _start});
+}
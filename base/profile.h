@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// per cell counters filled by the compare
+constexpr const char* COUNTER_ITERATIONS = "iterations";
+constexpr const char* COUNTER_DEVICE_BUCKETS = "device_buckets";
+constexpr const char* COUNTER_NET_BUCKETS = "net_buckets";
+constexpr const char* COUNTER_AUTOMORPHISM_GROUPS = "automorphism_groups";
+constexpr const char* COUNTER_FORCED_RESOLUTIONS = "forced_resolutions";
+constexpr const char* COUNTER_PLACEMENT_RESOLUTIONS = "placement_resolutions";
+constexpr const char* COUNTER_PORT_CLASS_CHECKS = "port_class_checks"; // compares run by ConfirmPortRelabel
+
+// Low overhead timers and counters. Every thread writes to its own buffer, buffers are only
+// merged when exporting, so workers of MultiThreadHierarchyCompare never wait on each other.
+class Profile {
+    private:
+        friend class ScopedTimer;
+        struct Event {
+            const char* name;
+            std::string cell;
+            int64_t start; // us since profile start
+            int64_t duration; // us
+        };
+        struct ThreadBuffer {
+            uint32_t threadId;
+            std::vector<Event> events;
+            std::map<std::string, std::map<std::string, int64_t> > counters; // cell -> counter -> value
+        };
+    private:
+        bool _enabled{false};
+        std::chrono::steady_clock::time_point _start;
+        std::mutex _buffersMutex; // only taken when a thread writes for the first time
+        std::vector<std::unique_ptr<ThreadBuffer> > _buffers;
+    private:
+        Profile();
+        ThreadBuffer& GetThreadBuffer();
+        int64_t Now() const;
+    public:
+        static Profile& GetInstance();
+
+        void SetEnabled(bool enabled);
+        bool IsEnabled() const;
+
+        void Count(const std::string& cell, const char* counter, int64_t value = 1);
+        int64_t GetTotalTime(const std::string& name); // us of all events with this name
+        void Clear();
+        bool ExportChromeTrace(const std::string& fileName);
+        bool ExportCellCsv(const std::string& fileName);
+};
+
+class ScopedTimer {
+    private:
+        const char* _name;
+        std::string _cell;
+        int64_t _start;
+        bool _enabled;
+    public:
+        explicit ScopedTimer(const char* name, const std::string& cell = "");
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator= (const ScopedTimer&) = delete;
+        ~ScopedTimer();
+};
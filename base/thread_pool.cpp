@@ -0,0 +1,59 @@
+#include <algorithm>
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threadNum) {
+    threadNum = std::max<size_t>(threadNum, 1);
+    for (size_t i = 0; i < threadNum; ++i) {
+        _workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stop = true;
+    }
+    _cvQueueNotEmpty.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::GetInstance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+size_t ThreadPool::GetThreadNum() const {
+    return _workers.size();
+}
+
+bool ThreadPool::RunPendingTask() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if (_tasks.empty()) {
+            return false;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop();
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _cvQueueNotEmpty.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+            if (_stop && _tasks.empty()) {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+        task();
+    }
+}
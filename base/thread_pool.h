@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    private:
+        std::vector<std::thread> _workers;
+        std::queue<std::function<void()> > _tasks;
+        std::mutex _queueMutex;
+        std::condition_variable _cvQueueNotEmpty;
+        bool _stop{false};
+    private:
+        void WorkerLoop();
+    public:
+        explicit ThreadPool(size_t threadNum = std::thread::hardware_concurrency());
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator= (const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        static ThreadPool& GetInstance(); // shared pool, stays warm for the whole process
+        size_t GetThreadNum() const;
+
+        template <typename F>
+        std::future<std::invoke_result_t<F> > Submit(F&& task) {
+            auto packagedTask = std::make_shared<std::packaged_task<std::invoke_result_t<F>()> >(std::forward<F>(task));
+            std::future<std::invoke_result_t<F> > result = packagedTask->get_future();
+            {
+                std::lock_guard<std::mutex> lock(_queueMutex);
+                _tasks.emplace([packagedTask]() { (*packagedTask)(); });
+            }
+            _cvQueueNotEmpty.notify_one();
+            return result;
+        }
+
+        // tasks waiting on subtasks run queued work meanwhile, so nested Submit can't starve the pool
+        template <typename FUTURE>
+        decltype(auto) Wait(FUTURE& result) {
+            while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!RunPendingTask()) {
+                    result.wait_for(std::chrono::milliseconds(1));
+                }
+            }
+            return result.get();
+        }
+        bool RunPendingTask(); // false if the queue is empty
+};
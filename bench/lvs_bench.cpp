@@ -0,0 +1,170 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "netlist_generator.h"
+#include "../compare/compare_netlist.h"
+#include "../netlist/memory_report.h"
+#include "../parse/library_cache.h"
+
+// usage: lvs_bench <sram XxY,...|hier DEPTHxFANOUT,...|logic GATES,...> [--swap N] [--size N] [--seed N]
+// e.g. lvs_bench sram 16x16,64x64,256x256 --swap 1
+
+struct BenchResult {
+    uint64_t devices;
+    double parse, link, hierarchy, compare, flatten; // s, flatten is part of compare summed over its workers
+    uint64_t parseRss, compareRss; // peak bytes
+    COMPARE_NETLIST_RESULT result;
+};
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool RunOne(const GeneratorOptions& options, BenchResult& benchResult) {
+    NetlistGenerator generator(options);
+    const std::string file1 = "bench_1.sp", file2 = "bench_2.sp";
+    if (!generator.Generate(file1, false) || !generator.Generate(file2, true)) {
+        std::cout << "Error, can't write bench netlists" << std::endl;
+        return false;
+    }
+
+    Profile& profile = Profile::GetInstance();
+    profile.Clear();
+    MemoryReport& memoryReport = MemoryReport::GetInstance();
+    memoryReport.MarkPhase("generate");
+
+    // the load path of lvs: LibraryCache, Prepare and Freeze
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Netlist> netlists[2];
+    for (int i = 0; i < 2; ++i) {
+        if (LibraryCache::GetInstance().Load(i == 0 ? file1 : file2, NetlistGenerator::TOP_CELL, netlists[i]) != READ_OK) {
+            std::cout << "Error, can't parse bench netlist" << std::endl;
+            return false;
+        }
+        netlists[i]->Prepare();
+        if (Config::GetInstance().freeze) {
+            netlists[i]->Freeze();
+        }
+    }
+    benchResult.parse = Seconds(start);
+    benchResult.parseRss = MemoryReport::GetPeakRss();
+    memoryReport.MarkPhase("parse");
+
+    start = std::chrono::steady_clock::now();
+    CompareNetlist cmp(netlists[0], netlists[1]);
+    benchResult.result = cmp.Compare();
+    benchResult.compare = Seconds(start);
+    benchResult.compareRss = MemoryReport::GetPeakRss();
+    memoryReport.MarkPhase("compare");
+
+    // parse includes linking and hierarchy building and compare includes flattening, they are reported on their own as well
+    benchResult.link = profile.GetTotalTime("QuotePointToCell") * 1e-6;
+    benchResult.hierarchy = profile.GetTotalTime("BuildHierarchyStructure") * 1e-6;
+    benchResult.flatten = profile.GetTotalTime("Flatten") * 1e-6;
+    benchResult.devices = generator.GetDeviceNum();
+    return true;
+}
+
+// a whole decimal number that fits uint32_t, no sign
+static bool ParseCount(const char* text, uint32_t& value) {
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long number = strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || number > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+}
+
+static bool ParseScale(BENCH_KIND kind, const std::string& scale, GeneratorOptions& options) {
+    if (kind == BENCH_LOGIC) {
+        return ParseCount(scale.c_str(), options.gates) && options.gates != 0;
+    }
+    const size_t x = scale.find('x');
+    uint32_t a = 0, b = 0;
+    if (x == std::string::npos || !ParseCount(scale.substr(0, x).c_str(), a) || !ParseCount(scale.substr(x + 1).c_str(), b)
+        || a == 0 || b == 0) {
+        return false;
+    }
+    if (kind == BENCH_SRAM) {
+        options.x = a;
+        options.y = b;
+    } else {
+        options.depth = a;
+        options.fanout = b;
+    }
+    return true;
+}
+
+static int Usage() {
+    std::cout << "usage: lvs_bench <sram XxY,...|hier DEPTHxFANOUT,...|logic GATES,...> [--swap N] [--size N] [--seed N]" << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc % 2 == 0) {
+        return Usage();
+    }
+
+    GeneratorOptions options;
+    const std::string kind = argv[1];
+    if (kind != "sram" && kind != "hier" && kind != "logic") {
+        return Usage();
+    }
+    options.kind = kind == "sram" ? BENCH_SRAM : kind == "hier" ? BENCH_HIERARCHY : BENCH_LOGIC;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        uint32_t value = 0;
+        if (!ParseCount(argv[i + 1], value)) {
+            std::cout << "Error, " << argv[i] << " takes a number, got \"" << argv[i + 1] << "\"" << std::endl;
+            return Usage();
+        }
+        if (strcmp(argv[i], "--swap") == 0) {
+            options.swapNets = value;
+        } else if (strcmp(argv[i], "--size") == 0) {
+            options.sizeChanges = value;
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            options.seed = value;
+        } else {
+            return Usage();
+        }
+    }
+
+    Config& config = Config::GetInstance();
+    config.multiThread = true;
+    Profile::GetInstance().SetEnabled(true);
+
+    std::cout << std::left << std::setw(16) << "scale" << std::setw(12) << "devices" << std::setw(10) << "parse(s)"
+              << std::setw(10) << "link(s)" << std::setw(10) << "hier(s)" << std::setw(12) << "compare(s)"
+              << std::setw(12) << "flatten(s)"
+              << std::setw(14) << "ns/device" << std::setw(14) << "peak(MB)" << "result" << std::endl;
+
+    std::istringstream scales(argv[2]);
+    std::string scale;
+    while (std::getline(scales, scale, ',')) {
+        BenchResult benchResult;
+        if (!ParseScale(options.kind, scale, options)) {
+            std::cout << "Error, bad scale \"" << scale << "\"" << std::endl;
+            return Usage();
+        }
+        if (!RunOne(options, benchResult)) {
+            return 1;
+        }
+        std::cout << std::left << std::setw(16) << scale << std::setw(12) << benchResult.devices
+                  << std::setw(10) << benchResult.parse << std::setw(10) << benchResult.link
+                  << std::setw(10) << benchResult.hierarchy << std::setw(12) << benchResult.compare
+                  << std::setw(12) << benchResult.flatten
+                  << std::setw(14) << benchResult.compare * 1e9 / std::max<uint64_t>(benchResult.devices, 1)
+                  << std::setw(14) << std::max(benchResult.parseRss, benchResult.compareRss) / (1024.0 * 1024.0)
+                  << (benchResult.result == COMPARE_NETLIST_TRUE ? "true" : "false") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <fstream>
+#include <vector>
+#include "netlist_generator.h"
+
+NetlistGenerator::NetlistGenerator(const GeneratorOptions& options): _options(options) {}
+
+bool NetlistGenerator::InjectMismatch(uint32_t& remain, uint32_t oneIn) {
+    if (!_mismatch || remain == 0 || _mismatchRandom() % oneIn != 0) {
+        return false;
+    }
+    --remain;
+    return true;
+}
+
+void NetlistGenerator::WriteMosfet(std::ostream& out, const std::string& name, std::string drain, std::string gate, std::string source,
+                                   const std::string& bulk, const std::string& model, double w, double l) {
+    if (InjectMismatch(_swapNets, 8)) {
+        std::swap(gate, source);
+    }
+    if (InjectMismatch(_sizeChanges, 8)) {
+        w *= 1.5;
+    }
+    out << name << " " << drain << " " << gate << " " << source << " " << bulk << " " << model
+        << " L=" << l << " W=" << w << "\n";
+}
+
+void NetlistGenerator::WriteInverterCell(std::ostream& out) {
+    out << ".SUBCKT BENCH_INV A Z VDD VSS\n";
+    WriteMosfet(out, "M0", "Z", "A", "VDD", "VDD", "p12ll", 2.2e-07, 6e-08);
+    WriteMosfet(out, "M1", "Z", "A", "VSS", "VSS", "n12ll", 1.1e-07, 6e-08);
+    out << ".ENDS\n";
+}
+
+void NetlistGenerator::WriteSram(std::ostream& out) {
+    out << ".SUBCKT BENCH_BITCELL BL BLB WL VDD VSS\n";
+    WriteMosfet(out, "M0", "Q", "QB", "VDD", "VDD", "DNPLSVT", 9.5e-08, 6.5e-08);
+    WriteMosfet(out, "M1", "QB", "Q", "VDD", "VDD", "DNPLSVT", 9.5e-08, 6.5e-08);
+    WriteMosfet(out, "M2", "Q", "QB", "VSS", "VSS", "DNNPDSVT", 2.1e-07, 6.5e-08);
+    WriteMosfet(out, "M3", "QB", "Q", "VSS", "VSS", "DNNPDSVT", 2.1e-07, 6.5e-08);
+    WriteMosfet(out, "M4", "BL", "WL", "Q", "VSS", "DNNPGSVT", 1.25e-07, 7.5e-08);
+    WriteMosfet(out, "M5", "BLB", "WL", "QB", "VSS", "DNNPGSVT", 1.25e-07, 7.5e-08);
+    out << ".ENDS\n";
+
+    out << ".SUBCKT " << TOP_CELL;
+    for (uint32_t x = 0; x < _options.x; ++x) {
+        out << " BL[" << x << "] BLB[" << x << "]";
+    }
+    for (uint32_t y = 0; y < _options.y; ++y) {
+        out << " WL[" << y << "]";
+    }
+    out << " VDD VSS\n";
+    for (uint32_t y = 0; y < _options.y; ++y) {
+        for (uint32_t x = 0; x < _options.x; ++x) {
+            // a swapped word line moves one bitcell to the next row
+            const uint32_t row = InjectMismatch(_swapNets, 64) ? (y + 1) % _options.y : y;
+            out << "X" << y * _options.x + x << " BL[" << x << "] BLB[" << x << "] WL[" << row << "] VDD VSS BENCH_BITCELL\n";
+        }
+    }
+    out << ".ENDS\n";
+}
+
+void NetlistGenerator::WriteHierarchy(std::ostream& out) {
+    WriteInverterCell(out);
+    // level 0 is a chain of inverters, level i is a chain of fanout cells of level i - 1
+    for (uint32_t level = 0; level <= _options.depth; ++level) {
+        const bool top = level == _options.depth;
+        out << ".SUBCKT " << (top ? std::string(TOP_CELL) : "BENCH_L" + std::to_string(level)) << " A Z VDD VSS\n";
+        const std::string son = level == 0 ? "BENCH_INV" : "BENCH_L" + std::to_string(level - 1);
+        for (uint32_t i = 0; i < _options.fanout; ++i) {
+            const std::string in = i == 0 ? "A" : "N" + std::to_string(i);
+            const std::string outNet = i + 1 == _options.fanout ? "Z" : "N" + std::to_string(i + 1);
+            out << "X" << i << " " << in << " " << outNet << " VDD VSS " << son << "\n";
+        }
+        out << ".ENDS\n";
+    }
+}
+
+void NetlistGenerator::WriteLogic(std::ostream& out) {
+    const uint32_t inputs = std::max<uint32_t>(2, _options.gates / 16);
+    out << ".SUBCKT " << TOP_CELL;
+    for (uint32_t i = 0; i < inputs; ++i) {
+        out << " I" << i;
+    }
+    out << " VDD VSS\n";
+
+    // every gate reads from primary inputs or earlier gates, so the network is acyclic
+    std::vector<std::string> signals;
+    for (uint32_t i = 0; i < inputs; ++i) {
+        signals.emplace_back("I" + std::to_string(i));
+    }
+    uint32_t mosfet = 0;
+    auto Name = [&mosfet]() {
+        return "M" + std::to_string(mosfet++);
+    };
+    for (uint32_t gate = 0; gate < _options.gates; ++gate) {
+        const std::string z = "G" + std::to_string(gate);
+        const std::string a = signals[_random() % signals.size()];
+        const std::string b = signals[_random() % signals.size()];
+        const std::string mid = "S" + std::to_string(gate);
+        switch (_random() % 3) {
+            case 0: // INV
+                WriteMosfet(out, Name(), z, a, "VDD", "VDD", "p12ll", 2.2e-07, 6e-08);
+                WriteMosfet(out, Name(), z, a, "VSS", "VSS", "n12ll", 1.1e-07, 6e-08);
+                break;
+            case 1: // NAND2
+                WriteMosfet(out, Name(), z, a, "VDD", "VDD", "p12ll", 2.2e-07, 6e-08);
+                WriteMosfet(out, Name(), z, b, "VDD", "VDD", "p12ll", 2.2e-07, 6e-08);
+                WriteMosfet(out, Name(), z, a, mid, "VSS", "n12ll", 2.2e-07, 6e-08);
+                WriteMosfet(out, Name(), mid, b, "VSS", "VSS", "n12ll", 2.2e-07, 6e-08);
+                break;
+            default: // NOR2
+                WriteMosfet(out, Name(), mid, a, "VDD", "VDD", "p12ll", 4.4e-07, 6e-08);
+                WriteMosfet(out, Name(), z, b, mid, "VDD", "p12ll", 4.4e-07, 6e-08);
+                WriteMosfet(out, Name(), z, a, "VSS", "VSS", "n12ll", 1.1e-07, 6e-08);
+                WriteMosfet(out, Name(), z, b, "VSS", "VSS", "n12ll", 1.1e-07, 6e-08);
+                break;
+        }
+        signals.emplace_back(z);
+    }
+    out << ".ENDS\n";
+}
+
+bool NetlistGenerator::Generate(const std::string& fileName, bool mismatch) {
+    std::ofstream out(fileName);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    _random.seed(_options.seed);
+    _mismatchRandom.seed(_options.seed + 1);
+    _mismatch = mismatch;
+    _swapNets = _options.swapNets;
+    _sizeChanges = _options.sizeChanges;
+
+    out << "* generated by lvs_bench\n";
+    switch (_options.kind) {
+        case BENCH_SRAM:
+            WriteSram(out);
+            break;
+        case BENCH_HIERARCHY:
+            WriteHierarchy(out);
+            break;
+        default:
+            WriteLogic(out);
+            break;
+    }
+    return true;
+}
+
+uint64_t NetlistGenerator::GetDeviceNum() const {
+    switch (_options.kind) {
+        case BENCH_SRAM:
+            return 6ull * _options.x * _options.y;
+        case BENCH_HIERARCHY: {
+            uint64_t num = 2;
+            for (uint32_t level = 0; level <= _options.depth; ++level) {
+                num *= _options.fanout;
+            }
+            return num;
+        }
+        default:
+            return 3ull * _options.gates; // average of INV/NAND2/NOR2
+    }
+}
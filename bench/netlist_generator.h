@@ -0,0 +1,44 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <ostream>
+
+typedef uint8_t BENCH_KIND;
+constexpr BENCH_KIND BENCH_SRAM = 0; // X*Y bitcell array
+constexpr BENCH_KIND BENCH_HIERARCHY = 1; // depth levels, every level quotes fanout cells of the next one
+constexpr BENCH_KIND BENCH_LOGIC = 2; // random INV/NAND2/NOR2 network
+
+struct GeneratorOptions {
+    BENCH_KIND kind = BENCH_SRAM;
+    uint32_t x = 16, y = 16; // sram
+    uint32_t depth = 4, fanout = 4; // hierarchy
+    uint32_t gates = 1000; // logic
+    uint32_t swapNets = 0; // mismatches injected into the second netlist
+    uint32_t sizeChanges = 0;
+    uint32_t seed = 1;
+};
+
+// writes parameterized SPICE netlists with the same syntax as the extracted layouts
+class NetlistGenerator {
+    private:
+        GeneratorOptions _options;
+        std::mt19937 _random; // structure, same sequence for both netlists
+        std::mt19937 _mismatchRandom; // only drawn from when injecting mismatches
+        bool _mismatch{false};
+        uint32_t _swapNets{0}, _sizeChanges{0}; // mismatches still to inject
+    private:
+        bool InjectMismatch(uint32_t& remain, uint32_t oneIn);
+        void WriteMosfet(std::ostream& out, const std::string& name, std::string drain, std::string gate, std::string source,
+                         const std::string& bulk, const std::string& model, double w, double l);
+        void WriteInverterCell(std::ostream& out);
+        void WriteSram(std::ostream& out);
+        void WriteHierarchy(std::ostream& out);
+        void WriteLogic(std::ostream& out);
+    public:
+        static constexpr const char* TOP_CELL = "BENCH_TOP";
+
+        explicit NetlistGenerator(const GeneratorOptions& options);
+        bool Generate(const std::string& fileName, bool mismatch); // mismatch: inject swapNets/sizeChanges
+        uint64_t GetDeviceNum() const; // flattened mosfet number
+};
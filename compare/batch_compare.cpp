@@ -0,0 +1,102 @@
+#include <iomanip>
+#include <map>
+#include "batch_compare.h"
+#include "../parse/library_cache.h"
+
+void BatchCompare::AddCase(const TestCase& testCase) {
+    BatchCase batchCase;
+    batchCase.file1 = testCase.file1;
+    batchCase.topCell1 = testCase.topCell1;
+    batchCase.file2 = testCase.file2;
+    batchCase.topCell2 = testCase.topCell2;
+    _cases.emplace_back(batchCase);
+}
+
+READ_STATE BatchCompare::Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist) {
+    // a file shared by several pairs is parsed once, every group edits its own clone
+    READ_STATE readState = IncrementalLoader::GetInstance().Load(fileName, topCellName, netlist);
+    if (readState == INCLUDE_FOUND) {
+        readState = LibraryCache::GetInstance().Load(fileName, topCellName, netlist); // the main file alone is parsed again
+    }
+    return readState;
+}
+
+void BatchCompare::RunGroup(const std::vector<size_t>& caseIndexes) {
+    const BatchCase& first = _cases[caseIndexes.front()];
+    std::ostringstream orderKey;
+    orderKey << "case " << std::setw(6) << std::setfill('0') << caseIndexes.front(); // a group reports under its first case
+    const ScopedOrderKey scopedOrderKey(orderKey.str());
+
+    // both files are parsed concurrently
+    std::shared_ptr<Netlist> netlist1, netlist2;
+    ThreadPool& threadPool = ThreadPool::GetInstance();
+    std::future<READ_STATE> read1 = threadPool.Submit([&]() { return Load(first.file1, first.topCell1, netlist1); });
+    std::future<READ_STATE> read2 = threadPool.Submit([&]() { return Load(first.file2, first.topCell2, netlist2); });
+    READ_STATE readState = threadPool.Wait(read1); // RunGroup is a pool task itself
+    const READ_STATE readState2 = threadPool.Wait(read2);
+    if (readState == READ_OK) {
+        readState = readState2;
+    }
+
+    std::vector<CELL_NAME> topCells1, topCells2;
+    for (size_t index : caseIndexes) {
+        topCells1.emplace_back(_cases[index].topCell1);
+        topCells2.emplace_back(_cases[index].topCell2);
+    }
+    if (readState == READ_OK && (readState = netlist1->SetTopCells(topCells1)) == READ_OK) {
+        readState = netlist2->SetTopCells(topCells2);
+    }
+    if (readState != READ_OK) {
+        for (size_t index : caseIndexes) {
+            _cases[index].readState = readState;
+        }
+        return;
+    }
+    netlist1->Prepare();
+    netlist2->Prepare();
+    if (Config::GetInstance().freeze) {
+        netlist1->Freeze();
+        netlist2->Freeze();
+    }
+
+    CompareNetlist cmp(netlist1, netlist2);
+    for (size_t index : caseIndexes) {
+        cmp.PairCells(_cases[index].topCell1, _cases[index].topCell2); // the names of the two tops of a case may differ
+    }
+    const COMPARE_NETLIST_RESULT result = cmp.Compare();
+    for (size_t index : caseIndexes) {
+        BatchCase& batchCase = _cases[index];
+        if (result == COMPARE_NETLIST_TRUE || cmp.GetCellResult(batchCase.topCell1) == COMPARE_CELL_TRUE) {
+            batchCase.result = COMPARE_NETLIST_TRUE;
+        }
+    }
+}
+
+void BatchCompare::Run() {
+    std::map<std::pair<std::string, std::string>, std::vector<size_t> > groups;
+    for (size_t i = 0; i < _cases.size(); ++i) {
+        groups[{_cases[i].file1, _cases[i].file2}].emplace_back(i);
+    }
+    // groups of different file pairs overlap, each writes only its own cases and reports under its order key
+    ThreadPool& threadPool = ThreadPool::GetInstance();
+    std::vector<std::future<void> > runs;
+    for (const auto& it : groups) {
+        runs.emplace_back(threadPool.Submit([this, &it]() { RunGroup(it.second); }));
+    }
+    for (std::future<void>& run : runs) {
+        threadPool.Wait(run);
+    }
+}
+
+std::string BatchCompare::Report() const {
+    std::ostringstream out;
+    for (const BatchCase& batchCase : _cases) {
+        out << batchCase.topCell1 << " (" << batchCase.file1 << ") vs " << batchCase.topCell2 << " (" << batchCase.file2 << "): ";
+        if (batchCase.readState != READ_OK) {
+            out << "read error " << static_cast<int16_t>(batchCase.readState) << std::endl;
+        } else {
+            out << (batchCase.result == COMPARE_NETLIST_TRUE ? "Compare True" : "Compare False") << std::endl;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "compare_netlist.h"
+#include "../base/thread_pool.h"
+#include "../parse/incremental_loader.h"
+
+// Compare many top cells of the same two files in one process. Every file pair is parsed once,
+// a synthetic top cell quotes all requested top cells, and one hierarchical compare schedules
+// every cell on its thread pool, so subcells shared by several top cells are compared once.
+class BatchCompare {
+    private:
+        struct BatchCase {
+            std::string file1, topCell1, file2, topCell2;
+            READ_STATE readState{READ_OK};
+            COMPARE_NETLIST_RESULT result{COMPARE_NETLIST_FALSE};
+        };
+        std::vector<BatchCase> _cases;
+    private:
+        static READ_STATE Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist);
+        void RunGroup(const std::vector<size_t>& caseIndexes);
+    public:
+        void AddCase(const TestCase& testCase);
+        void Run();
+        std::string Report() const;
+};
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include "compare_cell.h"
+
+constexpr HASH_VALUE NET_COLOR = 350631349ll;
+constexpr HASH_VALUE PORT_NET_COLOR = 845723999ll;
+constexpr HASH_VALUE FORCE_COLOR = 623887483ll;
+constexpr HASH_VALUE PIN_COLOR = 139821659ll;
+constexpr HASH_VALUE PROPERTY_COLOR = 143283523ll;
+
+static HASH_VALUE GetNameHash(const std::string& name) {
+    return StringCaseInsensitiveHash()(name) % HASH_MOD_2;
+}
+
+CompareCell::CompareCell(const std::shared_ptr<Cell>& cell1, const std::shared_ptr<Cell>& cell2): _cell1(cell1), _cell2(cell2) {}
+
+void CompareCell::LoadData() {
+    for (const std::shared_ptr<Cell>& cell : {_cell1, _cell2}) {
+        const NETLIST_ID id = cell == _cell1 ? NETLIST_1 : NETLIST_2;
+        for (const auto& it : cell->GetNets()) {
+            const std::shared_ptr<Net>& net = it.second;
+            // floating nets, e.g. left behind by a flattened quote, are not part of the circuit
+            if (net->GetConnectDevices().empty() && net->GetPortIndex() == NOT_PORT) {
+                continue;
+            }
+            _nets.emplace(net, std::make_shared<NetElement>(net, id));
+        }
+
+        for (const auto& it : cell->GetDevices()) {
+            const std::shared_ptr<DeviceElement> deviceElement = std::make_shared<DeviceElement>(it.second, id);
+            for (const auto& [net, pinMagic] : it.second->GetConnectNets()) {
+                const std::shared_ptr<NetElement>& netElement = _nets[net];
+                deviceElement->_connectNetElements.emplace_back(netElement, pinMagic);
+                netElement->_connectDeviceElements.emplace_back(deviceElement, pinMagic);
+            }
+            _deviceElements.emplace_back(deviceElement);
+        }
+    }
+}
+
+bool CompareCell::AssignInitialBuckets() {
+    // sizes that PropertyCompare would reject start in different buckets, so a size-only mismatch fails early
+    BuildPropertyBins();
+    const bool propertyColoring = Config::GetInstance().propertyColoring;
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        const std::shared_ptr<Device>& device = deviceElement->device;
+        deviceElement->oldColor = MixHash(device->GetDeviceType(), GetNameHash(device->GetModel()));
+        if (propertyColoring) {
+            deviceElement->oldColor = MixHash(deviceElement->oldColor, GetDevicePropertyColor(deviceElement));
+        }
+        deviceElement->newColor = deviceElement->oldColor;
+    }
+    // ports only match ports, their labels are what the parents see
+    for (const auto& it : _nets) {
+        const std::shared_ptr<NetElement>& netElement = it.second;
+        netElement->oldColor = it.first->GetPortIndex() == NOT_PORT ? NET_COLOR : PORT_NET_COLOR;
+        netElement->newColor = netElement->oldColor;
+    }
+    if (_portRelabel != nullptr) {
+        SeedPortLabels();
+    }
+    FindHubNets();
+    SeedNameAnchors();
+    InitHubNeighbors();
+
+    _deviceBuckets[_lastBucketsId ^ 1].clear();
+    _netBuckets[_lastBucketsId ^ 1].clear();
+    AssignBuckets();
+    return BucketsCheck() >= 0;
+}
+
+AUTOMORPHISM_GROUPS CompareCell::WeisfeilerLehman() {
+    ITERATE_STATUS status = ITERATE_WILL_CONTINUE;
+    while (status == ITERATE_WILL_CONTINUE && !IsCancelled()) {
+        status = Iterate();
+        if (!ValidateAnchors()) {
+            status = ITERATE_RESULT_FALSE; // Compare starts over without anchors
+        }
+    }
+    LVS_TRACE(TRACE_WL, OUT << "WL " << _cell1->GetName() << " vs " << _cell2->GetName() << ": " << status << std::endl);
+    return status;
+}
+
+ITERATE_STATUS CompareCell::Iterate() {
+    CountProfile(COUNTER_ITERATIONS);
+    IterateColor();
+    _lastBucketsId ^= 1;
+    AssignBuckets();
+
+    const AUTOMORPHISM_GROUPS groups = BucketsCheck();
+    LVS_TRACE(TRACE_ITERATE, OUT << "iterate " << _cell1->GetName() << ": " << _deviceBuckets[_lastBucketsId].size() << " device buckets, "
+        << _netBuckets[_lastBucketsId].size() << " net buckets, " << groups << " groups" << std::endl);
+    if (groups < 0) {
+        return ITERATE_RESULT_FALSE;
+    }
+    // colors only refine, so the same number of buckets as the step before is a fixed point
+    const uint8_t lastBucketsId = _lastBucketsId ^ 1;
+    if (_deviceBuckets[_lastBucketsId].size() != _deviceBuckets[lastBucketsId].size()
+        || _netBuckets[_lastBucketsId].size() != _netBuckets[lastBucketsId].size()) {
+        return ITERATE_WILL_CONTINUE;
+    }
+    return groups;
+}
+
+void CompareCell::AssignBuckets() {
+    AssignDeviceBuckets();
+    AssignNetBuckets();
+}
+
+void CompareCell::AssignDeviceBuckets() {
+    std::unordered_map<std::shared_ptr<DeviceElement>, DeviceBucket, DeviceElementHash, DeviceElementEqual>& buckets = _deviceBuckets[_lastBucketsId];
+    buckets.clear();
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        DeviceBucket& bucket = buckets[deviceElement];
+        if (bucket.graphNodes.empty()) {
+            static_cast<GraphNode&>(bucket) = *deviceElement;
+        }
+        bucket.graphNodes.emplace_back(deviceElement);
+    }
+}
+
+void CompareCell::AssignNetBuckets() {
+    std::unordered_map<std::shared_ptr<NetElement>, NetBucket, NetElementHash, NetElementEqual>& buckets = _netBuckets[_lastBucketsId];
+    buckets.clear();
+    for (const auto& it : _nets) {
+        NetBucket& bucket = buckets[it.second];
+        if (bucket.graphNodes.empty()) {
+            static_cast<GraphNode&>(bucket) = *it.second;
+        }
+        bucket.graphNodes.emplace_back(it.second);
+    }
+}
+
+void CompareCell::IterateColor() {
+    AssignNewDeviceColorToOld();
+    AssignNewNetColorToOld();
+    UpdateDevicesColor();
+    UpdateNetsColor();
+}
+
+void CompareCell::AssignNewDeviceColorToOld() {
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        UpdateHubNeighbors(deviceElement, deviceElement->oldColor, deviceElement->newColor);
+        deviceElement->oldColor = deviceElement->newColor;
+    }
+}
+
+void CompareCell::AssignNewNetColorToOld() {
+    for (const auto& it : _nets) {
+        it.second->oldColor = it.second->newColor;
+    }
+}
+
+void CompareCell::UpdateDevicesColor() {
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        deviceElement->newColor = GetDeviceNewColor(deviceElement);
+    }
+}
+
+void CompareCell::UpdateNetsColor() {
+    for (const auto& it : _nets) {
+        // a hub would cost its whole degree, its neighbor sum is kept up to date instead
+        it.second->newColor = it.second->hub ? GetHubNetNewColor(it.second) : GetNetNewColor(it.second);
+    }
+}
+
+HASH_VALUE CompareCell::GetDeviceNewColor(const std::shared_ptr<DeviceElement>& deviceElement) {
+    // a sum, so pins with the same pin magic are permutable
+    HASH_VALUE sum = 0;
+    for (const auto& [netElement, pinMagic] : deviceElement->_connectNetElements) {
+        sum += MixHash(netElement->oldColor, pinMagic);
+    }
+    return MixHash(deviceElement->oldColor, sum % HASH_MOD_2);
+}
+
+HASH_VALUE CompareCell::GetNetNewColor(const std::shared_ptr<NetElement>& netElement) {
+    HASH_VALUE sum = 0;
+    for (const auto& [weakDeviceElement, pinMagic] : netElement->_connectDeviceElements) {
+        sum += MixHash(weakDeviceElement.lock()->oldColor, pinMagic);
+    }
+    return MixHash(netElement->oldColor, sum % HASH_MOD_2);
+}
+
+AUTOMORPHISM_GROUPS CompareCell::BucketsCheck() {
+    _automorphismDeviceBuckets.clear();
+    _automorphismNetBuckets.clear();
+    const AUTOMORPHISM_GROUPS deviceGroups = DeviceBucketsCheck(_deviceBuckets[_lastBucketsId]);
+    if (deviceGroups < 0) {
+        return ITERATE_RESULT_FALSE;
+    }
+    const AUTOMORPHISM_GROUPS netGroups = NetBucketsCheck(_netBuckets[_lastBucketsId]);
+    if (netGroups < 0) {
+        return ITERATE_RESULT_FALSE;
+    }
+    return deviceGroups + netGroups;
+}
+
+AUTOMORPHISM_GROUPS CompareCell::DeviceBucketsCheck(std::unordered_map<std::shared_ptr<DeviceElement>, DeviceBucket, DeviceElementHash, DeviceElementEqual>& buckets) {
+    AUTOMORPHISM_GROUPS groups = 0;
+    for (auto& it : buckets) {
+        const AUTOMORPHISM_GROUPS bucketGroups = DeviceBucketCheck(it.second);
+        if (bucketGroups < 0) {
+            return ITERATE_RESULT_FALSE;
+        }
+        groups += bucketGroups;
+    }
+    return groups;
+}
+
+AUTOMORPHISM_GROUPS CompareCell::NetBucketsCheck(std::unordered_map<std::shared_ptr<NetElement>, NetBucket, NetElementHash, NetElementEqual>& buckets) {
+    AUTOMORPHISM_GROUPS groups = 0;
+    for (auto& it : buckets) {
+        const AUTOMORPHISM_GROUPS bucketGroups = NetBucketCheck(it.second);
+        if (bucketGroups < 0) {
+            return ITERATE_RESULT_FALSE;
+        }
+        groups += bucketGroups;
+    }
+    return groups;
+}
+
+AUTOMORPHISM_GROUPS CompareCell::DeviceBucketCheck(DeviceBucket& bucket) {
+    size_t counts[2] = {0, 0};
+    for (const std::shared_ptr<DeviceElement>& deviceElement : bucket.graphNodes) {
+        ++counts[deviceElement->netlistId];
+    }
+    if (counts[NETLIST_1] != counts[NETLIST_2]) {
+        LVS_TRACE(TRACE_ITERATE, OUT << "device bucket of " << bucket.name << ": " << counts[NETLIST_1] << " vs " << counts[NETLIST_2] << std::endl);
+        return ITERATE_RESULT_FALSE;
+    }
+    if (counts[NETLIST_1] == 1) {
+        // matched, sizes are checked within Config::tolerance
+        return bucket.graphNodes[0]->device->PropertyCompare(bucket.graphNodes[1]->device) ? 0 : ITERATE_RESULT_FALSE;
+    }
+    _automorphismDeviceBuckets.emplace_back(&bucket);
+    return 1;
+}
+
+AUTOMORPHISM_GROUPS CompareCell::NetBucketCheck(NetBucket& bucket) {
+    size_t counts[2] = {0, 0};
+    for (const std::shared_ptr<NetElement>& netElement : bucket.graphNodes) {
+        ++counts[netElement->netlistId];
+    }
+    if (counts[NETLIST_1] != counts[NETLIST_2]) {
+        LVS_TRACE(TRACE_ITERATE, OUT << "net bucket of " << bucket.name << ": " << counts[NETLIST_1] << " vs " << counts[NETLIST_2] << std::endl);
+        return ITERATE_RESULT_FALSE;
+    }
+    if (counts[NETLIST_1] == 1) {
+        return 0;
+    }
+    _automorphismNetBuckets.emplace_back(&bucket);
+    return 1;
+}
+
+COMPARE_CELL_RESULT CompareCell::ResolveAutomorphism() {
+    AUTOMORPHISM_GROUPS groups = _automorphismDeviceBuckets.size() + _automorphismNetBuckets.size();
+    while (groups > 0) {
+        // exact choices first, a forced one is a guess that can split a real match
+        bool resolved = ResolveAutomorphismByProperty();
+        resolved = ResolveAutomorphismByPin() || resolved;
+        if (!resolved) {
+            // a placement pairing is a guess too, when the refinement refutes it the colors go back and one pair is forced
+            if (Config::GetInstance().placementColoring) {
+                const ColorSnapshot snapshot = SaveColors();
+                if (ResolveAutomorphismByPlacement()) {
+                    if ((groups = WeisfeilerLehman()) >= 0) {
+                        continue;
+                    }
+                    RestoreColors(snapshot);
+                }
+            }
+            CountProfile(COUNTER_FORCED_RESOLUTIONS);
+            ResolveAutomorphismForce();
+        }
+        groups = WeisfeilerLehman();
+    }
+    return groups == 0 ? COMPARE_CELL_TRUE : COMPARE_CELL_FALSE;
+}
+
+bool CompareCell::ResolveAutomorphismByProperty() {
+    const double tolerance = Config::GetInstance().tolerance;
+    typedef std::pair<std::vector<double>, std::shared_ptr<DeviceElement> > SIZED_DEVICE;
+    bool resolved = false;
+    for (DeviceBucket* bucket : _automorphismDeviceBuckets) {
+        std::vector<SIZED_DEVICE> sides[2];
+        for (const std::shared_ptr<DeviceElement>& deviceElement : bucket->graphNodes) {
+            sides[deviceElement->netlistId].emplace_back(deviceElement->device->GetSizes(), deviceElement);
+        }
+
+        // a new group starts where some size jumps by more than the tolerance
+        std::vector<size_t> groups[2];
+        for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+            std::sort(sides[id].begin(), sides[id].end(), [](const SIZED_DEVICE& a, const SIZED_DEVICE& b) {
+                return a.first < b.first;
+            });
+            size_t group = 0;
+            for (size_t i = 0; i < sides[id].size(); ++i) {
+                const std::vector<double>& sizes = sides[id][i].first;
+                for (size_t k = 0; i != 0 && k < sizes.size(); ++k) {
+                    if (sizes[k] - sides[id][i - 1].first[k] > tolerance) {
+                        ++group;
+                        break;
+                    }
+                }
+                groups[id].emplace_back(group);
+            }
+        }
+        // one group has nothing to split, different groups are left to the property check of the matched pairs
+        if (groups[NETLIST_1] != groups[NETLIST_2] || groups[NETLIST_1].back() == 0) {
+            continue;
+        }
+
+        for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+            for (size_t i = 0; i < sides[id].size(); ++i) {
+                sides[id][i].second->newColor = MixHash(MixHash(bucket->newColor, PROPERTY_COLOR), groups[id][i] + 1);
+            }
+        }
+        resolved = true;
+    }
+    return resolved;
+}
+
+bool CompareCell::ResolveAutomorphismByPin() {
+    // symmetric port nets with the same name in both cells are taken as the match
+    bool resolved = false;
+    for (NetBucket* bucket : _automorphismNetBuckets) {
+        std::unordered_set<std::shared_ptr<NetElement> > ports2;
+        for (const std::shared_ptr<NetElement>& netElement : bucket->graphNodes) {
+            if (netElement->netlistId == NETLIST_2 && netElement->net->GetPortIndex() != NOT_PORT) {
+                ports2.insert(netElement);
+            }
+        }
+
+        HASH_VALUE pairNum = 0;
+        for (const std::shared_ptr<NetElement>& netElement1 : bucket->graphNodes) {
+            if (netElement1->netlistId != NETLIST_1 || netElement1->net->GetPortIndex() == NOT_PORT) {
+                continue;
+            }
+            const auto it2 = _nets.find(_cell2->FindNet(netElement1->name));
+            if (it2 == _nets.end() || !ports2.count(it2->second)) {
+                continue;
+            }
+            netElement1->newColor = it2->second->newColor = MixHash(MixHash(bucket->newColor, PIN_COLOR), ++pairNum);
+        }
+        resolved = resolved || pairNum != 0;
+    }
+    return resolved;
+}
+
+void CompareCell::ResolveAutomorphismForce() {
+    // one pair of the smallest group, the refinement that follows usually settles its neighbors
+    DeviceBucket* deviceBucket = nullptr;
+    for (DeviceBucket* bucket : _automorphismDeviceBuckets) {
+        if (deviceBucket == nullptr || *deviceBucket > *bucket) {
+            deviceBucket = bucket;
+        }
+    }
+    NetBucket* netBucket = nullptr;
+    for (NetBucket* bucket : _automorphismNetBuckets) {
+        if (netBucket == nullptr || *netBucket > *bucket) {
+            netBucket = bucket;
+        }
+    }
+
+    if (deviceBucket != nullptr && (netBucket == nullptr || !(*deviceBucket > *netBucket))) {
+        ResetDeviceBucketColor(*deviceBucket);
+    } else if (netBucket != nullptr) {
+        ResetNetBucketColor(*netBucket);
+    }
+}
+
+void CompareCell::ResetDeviceBucketColor(DeviceBucket& bucket) {
+    std::shared_ptr<DeviceElement> chosen[2];
+    for (const std::shared_ptr<DeviceElement>& deviceElement : bucket.graphNodes) {
+        if (chosen[deviceElement->netlistId] == nullptr) {
+            chosen[deviceElement->netlistId] = deviceElement;
+        }
+    }
+    chosen[NETLIST_1]->newColor = chosen[NETLIST_2]->newColor = MixHash(bucket.newColor, FORCE_COLOR);
+}
+
+void CompareCell::ResetNetBucketColor(NetBucket& bucket) {
+    std::shared_ptr<NetElement> chosen[2];
+    for (const std::shared_ptr<NetElement>& netElement : bucket.graphNodes) {
+        if (chosen[netElement->netlistId] == nullptr) {
+            chosen[netElement->netlistId] = netElement;
+        }
+    }
+    chosen[NETLIST_1]->newColor = chosen[NETLIST_2]->newColor = MixHash(bucket.newColor, FORCE_COLOR);
+}
+
+COMPARE_CELL_RESULT CompareCell::Compare() {
+    ScopedTimer timer("CompareCell", _cell1->GetName());
+    LoadData();
+    COMPARE_CELL_RESULT result = Refine();
+    if (IsCancelled()) {
+        return COMPARE_CELL_CANCELLED; // the verdict of an interrupted WL means nothing
+    }
+    if (result == COMPARE_CELL_FALSE && (!_anchoredNets.empty() || !_anchoredDevices.empty())) {
+        // a wrong name anchor can fail cells that plain WL matches
+        _anchorsDisabled = true;
+        result = Refine();
+    }
+
+    ProfileBuckets();
+    if (Config::GetInstance().memoryReport) {
+        AccountMemory(); // the element graph and buckets are still alive here
+    }
+    return result;
+}
+
+COMPARE_CELL_RESULT CompareCell::Refine() {
+    if (!AssignInitialBuckets()) {
+        return COMPARE_CELL_FALSE;
+    }
+    if (WeisfeilerLehman() < 0) {
+        return COMPARE_CELL_FALSE;
+    }
+    RecordPortColors();
+    return ResolveAutomorphism();
+}
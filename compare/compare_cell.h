@@ -1,9 +1,14 @@
 #pragma once
 
+#include <tuple>
 #include <unordered_set>
 #include <any>
 #include "../parse/spice.h"
 #include "../parse/layout.h"
+#include "property_bins.h"
+#include "../base/cancel_token.h"
+#include "../base/profile.h"
+#include "../netlist/memory_report.h"
 
 typedef std::string GRAPH_NODE_NAME;
 
@@ -50,6 +55,9 @@ class CompareCell {
         struct NetElement: public GraphNode {
             std::shared_ptr<Net> net;
             std::vector<std::pair<std::weak_ptr<DeviceElement>, PIN_MAGIC> > _connectDeviceElements;
+            bool hub{false};
+            bool fixedColor{false}; // hub matched by name or port, never refined
+            HASH_VALUE neighborSum{0}; // hub only, kept up to date by UpdateHubNeighbors
             NetElement(const std::shared_ptr<Net>& net_, const NETLIST_ID& id_): net(net_) {
                 name = net_->GetName();
                 oldColor = 0;
@@ -60,7 +68,7 @@ class CompareCell {
         };
         struct DeviceElementHash {
             size_t operator() (const std::shared_ptr<DeviceElement>& deviceElement) const {
-                return deviceElement->oldColor ^ deviceElement->newColor;
+                return MixHash(deviceElement->oldColor, deviceElement->newColor); // old ^ new is 0 for every element of the initial buckets
             }
         };
         struct DeviceElementEqual {
@@ -70,7 +78,7 @@ class CompareCell {
         };
         struct NetElementHash {
             size_t operator() (const std::shared_ptr<NetElement>& netElement) const {
-                return netElement->oldColor ^ netElement->newColor;
+                return MixHash(netElement->oldColor, netElement->newColor);
             }
         };
         struct NetElementEqual {
@@ -88,9 +96,57 @@ class CompareCell {
 
         std::vector<DeviceBucket*> _automorphismDeviceBuckets;
         std::vector<NetBucket*> _automorphismNetBuckets;
+
+        PropertyBins _propertyBins; // W/L bins shared by both cells
+        std::vector<std::shared_ptr<NetElement> > _hubNets;
+
+        std::vector<std::pair<std::shared_ptr<DeviceElement>, std::shared_ptr<DeviceElement> > > _anchoredDevices;
+        std::vector<std::pair<std::shared_ptr<NetElement>, std::shared_ptr<NetElement> > > _anchoredNets;
+        bool _anchorsDisabled{false}; // the anchored compare failed, Compare runs plain WL
+
+        std::vector<HASH_VALUE> _portColors[2]; // port net colors when WL first stalls
+        const std::unordered_map<size_t, size_t>* _portRelabel{nullptr}; // ConfirmPortRelabel only: port i of _cell1 takes the label of port relabel[i]
+
+        const CancelToken* _cancelToken{nullptr}; // polled once per iterate, Compare returns COMPARE_CELL_CANCELLED
+
+        struct ColorSnapshot { // element colors before a guess that may be taken back, in the order of _deviceElements and _nets
+            std::vector<std::pair<HASH_VALUE, HASH_VALUE> > devices; // old, new
+            std::vector<std::tuple<HASH_VALUE, HASH_VALUE, HASH_VALUE> > nets; // old, new, neighbor sum
+        };
     private:
         void LoadData();
         bool AssignInitialBuckets();
+        COMPARE_CELL_RESULT Refine(); // from the initial buckets to a verdict
+
+        // property
+        void BuildPropertyBins(); // start of AssignInitialBuckets
+        HASH_VALUE GetDevicePropertyColor(const std::shared_ptr<DeviceElement>& deviceElement) const; // folded into initial device color
+
+        // hub net
+        void FindHubNets(); // in AssignInitialBuckets, after the plain net colors
+        void InitHubNeighbors(); // once the initial device colors are final
+        void UpdateHubNeighbors(const std::shared_ptr<DeviceElement>& deviceElement, HASH_VALUE oldColor, HASH_VALUE newColor);
+        HASH_VALUE GetHubNetNewColor(const std::shared_ptr<NetElement>& netElement) const; // GetNetNewColor for hub nets
+
+        // name anchor
+        void SeedNameAnchors(); // in AssignInitialBuckets, after FindHubNets
+        bool ValidateAnchors() const; // after every Iterate, false if the structure contradicts some anchor
+        static HASH_VALUE GetNetSignature(const std::shared_ptr<NetElement>& netElement);
+
+        // port symmetry
+        void RecordPortColors(); // before the first ResolveAutomorphism
+        void SeedPortLabels(); // in AssignInitialBuckets when _portRelabel is set
+        bool ConfirmPortRelabel(const std::unordered_map<size_t, size_t>& relabel) const; // compares the cells again, ports labeled
+        bool QuotesSeparate(const std::vector<size_t>& members) const; // some quote of _cell1 wires two members to different nets
+        // label -> smallest label of its proven class; only classes some parent quote can tell apart are checked,
+        // quotedElsewhere: the parents of _cell1 are not in this netlist, every class is checked
+        std::unordered_map<PIN_MAGIC, PIN_MAGIC> ConfirmPortClasses(bool quotedElsewhere) const;
+        void ExportPortClasses(bool quotedElsewhere); // in DealCompareCellsTrue, after port labels are set
+
+        // profile, counters are keyed by the name of _cell1
+        void CountProfile(const char* counter, int64_t value = 1) const; // e.g. COUNTER_ITERATIONS in Iterate
+        void ProfileBuckets() const; // at the end of Compare
+        uint64_t AccountMemory() const; // DeviceElement/NetElement/bucket bytes into MemoryReport
 
         AUTOMORPHISM_GROUPS WeisfeilerLehman(); // WL algorithm
         ITERATE_STATUS Iterate(); // one iterate step
@@ -117,12 +173,23 @@ class CompareCell {
 
         // automorphism
         COMPARE_CELL_RESULT ResolveAutomorphism();
-        void ResolveAutomorphismByProperty();
-        void ResolveAutomorphismByPin();
+        bool ResolveAutomorphismByProperty(); // true if some group was split
+        bool ResolveAutomorphismByPin();
+        bool ResolveAutomorphismByPlacement(); // after ByPin, ResolveAutomorphismForce if it returns false or WL refutes it
+        ColorSnapshot SaveColors() const;
+        void RestoreColors(const ColorSnapshot& snapshot); // and the buckets of _lastBucketsId
         void ResolveAutomorphismForce();
         void ResetDeviceBucketColor(DeviceBucket& bucket);
         void ResetNetBucketColor(NetBucket& bucket);
     public:
         CompareCell(const std::shared_ptr<Cell>& cell1, const std::shared_ptr<Cell>& cell2);
         COMPARE_CELL_RESULT Compare();
+        // after COMPARE_CELL_FALSE: the smallest final buckets whose netlist counts differ, and their neighbors
+        std::string Diagnose(size_t bucketLimit = 8) const;
+        void SetCancelToken(const CancelToken* cancelToken) {
+            _cancelToken = cancelToken;
+        }
+        bool IsCancelled() const {
+            return _cancelToken != nullptr && _cancelToken->IsCancelled();
+        }
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include "compare_cell.h"
+
+constexpr HASH_VALUE ANCHOR_COLOR = 420117221ll;
+
+HASH_VALUE CompareCell::GetNetSignature(const std::shared_ptr<NetElement>& netElement) {
+    std::vector<HASH_VALUE> neighbors;
+    neighbors.reserve(netElement->_connectDeviceElements.size());
+    for (const auto& it : netElement->_connectDeviceElements) {
+        neighbors.emplace_back(MixHash(it.first.lock()->device->GetDeviceType(), it.second));
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+
+    HASH_VALUE signature = netElement->degree;
+    for (HASH_VALUE neighbor : neighbors) {
+        signature = MixHash(signature, neighbor);
+    }
+    return signature;
+}
+
+void CompareCell::SeedNameAnchors() {
+    _anchoredDevices.clear();
+    _anchoredNets.clear();
+    if (!Config::GetInstance().anchorByName || _anchorsDisabled) {
+        return;
+    }
+
+    HASH_VALUE anchorColor = ANCHOR_COLOR;
+    auto NextColor = [&anchorColor]() {
+        anchorColor = MixHash(anchorColor, ANCHOR_COLOR);
+        return anchorColor;
+    };
+
+    // FindNet/FindDevice follow Config::caseInsensitive
+    for (const auto& it : _nets) {
+        const std::shared_ptr<NetElement>& netElement1 = it.second;
+        if (netElement1->netlistId != NETLIST_1 || netElement1->fixedColor) {
+            continue;
+        }
+        const std::shared_ptr<Net> net2 = _cell2->FindNet(netElement1->name);
+        if (net2 == nullptr) {
+            continue;
+        }
+        const auto it2 = _nets.find(net2);
+        if (it2 == _nets.end() || it2->second->fixedColor) {
+            continue;
+        }
+        const std::shared_ptr<NetElement>& netElement2 = it2->second;
+        if (netElement1->oldColor != netElement2->oldColor || GetNetSignature(netElement1) != GetNetSignature(netElement2)) {
+            continue;
+        }
+
+        netElement1->oldColor = netElement2->oldColor = NextColor();
+        netElement1->newColor = netElement2->newColor = netElement1->oldColor;
+        _anchoredNets.emplace_back(netElement1, netElement2);
+    }
+
+    std::unordered_map<std::shared_ptr<Device>, std::shared_ptr<DeviceElement> > deviceElements2;
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        if (deviceElement->netlistId == NETLIST_2) {
+            deviceElements2.emplace(deviceElement->device, deviceElement);
+        }
+    }
+    for (const std::shared_ptr<DeviceElement>& deviceElement1 : _deviceElements) {
+        if (deviceElement1->netlistId != NETLIST_1) {
+            continue;
+        }
+        const auto it2 = deviceElements2.find(_cell2->FindDevice(deviceElement1->name));
+        if (it2 == deviceElements2.end()) {
+            continue;
+        }
+        const std::shared_ptr<DeviceElement>& deviceElement2 = it2->second;
+        if (deviceElement1->oldColor != deviceElement2->oldColor
+            || !deviceElement1->device->PropertyCompare(deviceElement2->device)) {
+            continue;
+        }
+
+        deviceElement1->oldColor = deviceElement2->oldColor = NextColor();
+        deviceElement1->newColor = deviceElement2->newColor = deviceElement1->oldColor;
+        _anchoredDevices.emplace_back(deviceElement1, deviceElement2);
+    }
+}
+
+bool CompareCell::ValidateAnchors() const {
+    // an anchored pair whose neighborhoods differ gets two colors after one iterate
+    for (const auto& [netElement1, netElement2] : _anchoredNets) {
+        if (netElement1->newColor != netElement2->newColor) {
+            return false;
+        }
+    }
+    for (const auto& [deviceElement1, deviceElement2] : _anchoredDevices) {
+        if (deviceElement1->newColor != deviceElement2->newColor) {
+            return false;
+        }
+    }
+    return true;
+}
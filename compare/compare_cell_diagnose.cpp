@@ -0,0 +1,130 @@
+#include <algorithm>
+#include "compare_cell.h"
+
+constexpr size_t DIAGNOSE_NAMES_PER_SIDE = 8;
+
+// "a b c (+4)" per netlist, netlist1 before the bar
+template <typename NODES>
+static std::string JoinNames(const NODES& nodes) {
+    std::vector<std::string> names[2];
+    for (const auto& node : nodes) {
+        names[node->netlistId].emplace_back(node->name);
+    }
+    std::string text;
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        std::sort(names[id].begin(), names[id].end());
+        for (size_t i = 0; i < names[id].size() && i < DIAGNOSE_NAMES_PER_SIDE; ++i) {
+            text += " " + names[id][i];
+        }
+        if (names[id].size() > DIAGNOSE_NAMES_PER_SIDE) {
+            text += " (+" + std::to_string(names[id].size() - DIAGNOSE_NAMES_PER_SIDE) + ")";
+        }
+        if (id == NETLIST_1) {
+            text += " |";
+        }
+    }
+    return text;
+}
+
+std::string CompareCell::Diagnose(size_t bucketLimit) const {
+    ScopedTimer timer("Diagnose", _cell1->GetName());
+    std::ostringstream out;
+    out << "diagnose " << _cell1->GetName() << " vs " << _cell2->GetName() << std::endl;
+
+    // a bucket whose sides differ in size holds what one netlist has and the other lacks; the smallest
+    // such buckets are the most specific, big ones usually only differ because of a small one
+    struct Unbalanced {
+        size_t counts[2]{0, 0};
+        const DeviceBucket* deviceBucket{nullptr};
+        const NetBucket* netBucket{nullptr};
+        size_t GetSize() const {
+            return counts[NETLIST_1] + counts[NETLIST_2];
+        }
+    };
+    std::vector<Unbalanced> unbalanced;
+    size_t deviceBucketNum = 0, netBucketNum = 0;
+    for (const auto& it : _deviceBuckets[_lastBucketsId]) {
+        Unbalanced bucket;
+        for (const std::shared_ptr<DeviceElement>& deviceElement : it.second.graphNodes) {
+            ++bucket.counts[deviceElement->netlistId];
+        }
+        if (bucket.counts[NETLIST_1] != bucket.counts[NETLIST_2]) {
+            bucket.deviceBucket = &it.second;
+            unbalanced.emplace_back(bucket);
+            ++deviceBucketNum;
+        }
+    }
+    for (const auto& it : _netBuckets[_lastBucketsId]) {
+        Unbalanced bucket;
+        for (const std::shared_ptr<NetElement>& netElement : it.second.graphNodes) {
+            ++bucket.counts[netElement->netlistId];
+        }
+        if (bucket.counts[NETLIST_1] != bucket.counts[NETLIST_2]) {
+            bucket.netBucket = &it.second;
+            unbalanced.emplace_back(bucket);
+            ++netBucketNum;
+        }
+    }
+
+    if (unbalanced.empty()) {
+        // no buckets were built, or forcing failed on balanced ones: fall back to device counts per model
+        std::map<DEVICE_MODEL_NAME, size_t> counts[2];
+        for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+            ++counts[deviceElement->netlistId][deviceElement->device->GetModel()];
+        }
+        for (const auto& [model, count] : counts[NETLIST_1]) {
+            if (counts[NETLIST_2][model] != count) {
+                out << "  model " << model << ": " << count << " vs " << counts[NETLIST_2][model] << std::endl;
+            }
+        }
+        for (const auto& [model, count] : counts[NETLIST_2]) {
+            if (counts[NETLIST_1].count(model) == 0) {
+                out << "  model " << model << ": 0 vs " << count << std::endl;
+            }
+        }
+        out << "  buckets are balanced, the mismatch is in automorphism resolution" << std::endl;
+        return out.str();
+    }
+
+    std::sort(unbalanced.begin(), unbalanced.end(), [](const Unbalanced& a, const Unbalanced& b) {
+        return a.GetSize() < b.GetSize();
+    });
+    out << "  " << deviceBucketNum << " device and " << netBucketNum << " net buckets differ" << std::endl;
+
+    // one hop out, hub nets are left out since they touch everything
+    for (size_t i = 0; i < unbalanced.size() && i < bucketLimit; ++i) {
+        const Unbalanced& bucket = unbalanced[i];
+        if (bucket.deviceBucket != nullptr) {
+            std::unordered_set<std::shared_ptr<NetElement> > neighbors;
+            for (const std::shared_ptr<DeviceElement>& deviceElement : bucket.deviceBucket->graphNodes) {
+                for (const auto& [netElement, pinMagic] : deviceElement->_connectNetElements) {
+                    if (!netElement->hub) {
+                        neighbors.insert(netElement);
+                    }
+                }
+            }
+            out << "  devices " << bucket.counts[NETLIST_1] << " vs " << bucket.counts[NETLIST_2] << ":"
+                << JoinNames(bucket.deviceBucket->graphNodes) << std::endl;
+            out << "    nets:" << JoinNames(neighbors) << std::endl;
+        } else {
+            std::unordered_set<std::shared_ptr<DeviceElement> > neighbors;
+            for (const std::shared_ptr<NetElement>& netElement : bucket.netBucket->graphNodes) {
+                if (netElement->hub) {
+                    continue;
+                }
+                for (const auto& [weakDeviceElement, pinMagic] : netElement->_connectDeviceElements) {
+                    if (const std::shared_ptr<DeviceElement> deviceElement = weakDeviceElement.lock()) {
+                        neighbors.insert(deviceElement);
+                    }
+                }
+            }
+            out << "  nets " << bucket.counts[NETLIST_1] << " vs " << bucket.counts[NETLIST_2] << ":"
+                << JoinNames(bucket.netBucket->graphNodes) << std::endl;
+            out << "    devices:" << JoinNames(neighbors) << std::endl;
+        }
+    }
+    if (unbalanced.size() > bucketLimit) {
+        out << "  (" << unbalanced.size() - bucketLimit << " larger buckets not shown)" << std::endl;
+    }
+    return out.str();
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cctype>
+#include "compare_cell.h"
+
+constexpr HASH_VALUE HUB_NET_COLOR = 479976251ll;
+
+static HASH_VALUE GetNeighborContribution(HASH_VALUE deviceColor, PIN_MAGIC pinMagic) {
+    return MixHash(deviceColor, pinMagic);
+}
+
+static HASH_VALUE GetNameColor(const NET_NAME& name) {
+    // case folds exactly when FindNet folds it: Config::caseInsensitive set means exact names, see StringCaseInsensitiveEqual
+    const bool foldCase = !Config::GetInstance().caseInsensitive;
+    HASH_VALUE color = HUB_NET_COLOR;
+    for (const char c : name) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        color = MixHash(color, foldCase ? std::tolower(byte) : byte);
+    }
+    return color;
+}
+
+void CompareCell::FindHubNets() {
+    const uint32_t hubNetDegree = Config::GetInstance().hubNetDegree;
+    const std::shared_ptr<Netlist> netlist1 = _cell1->GetNetlist(), netlist2 = _cell2->GetNetlist();
+    auto IsGlobal = [&](const NET_NAME& name) {
+        return netlist1->IsGlobalNet(name) || netlist2->IsGlobalNet(name);
+    };
+
+    _hubNets.clear();
+    for (const auto& it : _nets) {
+        const std::shared_ptr<NetElement>& netElement = it.second;
+        if ((hubNetDegree != 0 && netElement->degree >= hubNetDegree) || IsGlobal(netElement->name)) {
+            netElement->hub = true;
+            _hubNets.emplace_back(netElement);
+        }
+    }
+
+    // hubs which are ports or globals on both sides and have the same name are paired
+    for (const std::shared_ptr<NetElement>& netElement1 : _hubNets) {
+        if (netElement1->netlistId != NETLIST_1) {
+            continue;
+        }
+        const std::shared_ptr<Net>& net1 = netElement1->net;
+        const std::shared_ptr<Net> net2 = _cell2->FindNet(net1->GetName());
+        if (net2 == nullptr) {
+            continue;
+        }
+        const auto it2 = _nets.find(net2);
+        if (it2 == _nets.end() || !it2->second->hub || it2->second->degree != netElement1->degree) {
+            continue;
+        }
+        const bool global = IsGlobal(net1->GetName());
+        if (!global && (net1->GetPortIndex() == NOT_PORT || net2->GetPortIndex() == NOT_PORT)) {
+            continue;
+        }
+
+        const std::shared_ptr<NetElement>& netElement2 = it2->second;
+        netElement1->fixedColor = netElement2->fixedColor = true;
+        netElement1->oldColor = netElement2->oldColor = GetNameColor(net1->GetName());
+        netElement1->newColor = netElement2->newColor = netElement1->oldColor;
+    }
+}
+
+void CompareCell::InitHubNeighbors() {
+    for (const std::shared_ptr<NetElement>& netElement : _hubNets) {
+        netElement->neighborSum = 0;
+        for (const auto& it : netElement->_connectDeviceElements) {
+            netElement->neighborSum += GetNeighborContribution(it.first.lock()->oldColor, it.second);
+        }
+    }
+}
+
+void CompareCell::UpdateHubNeighbors(const std::shared_ptr<DeviceElement>& deviceElement, HASH_VALUE oldColor, HASH_VALUE newColor) {
+    if (oldColor == newColor || _hubNets.empty()) {
+        return;
+    }
+    // the sum is commutative, so a hub only pays for the devices that really changed
+    for (const auto& it : deviceElement->_connectNetElements) {
+        const std::shared_ptr<NetElement>& netElement = it.first;
+        if (netElement->hub) {
+            netElement->neighborSum += GetNeighborContribution(newColor, it.second) - GetNeighborContribution(oldColor, it.second);
+        }
+    }
+}
+
+HASH_VALUE CompareCell::GetHubNetNewColor(const std::shared_ptr<NetElement>& netElement) const {
+    if (netElement->fixedColor) {
+        return netElement->oldColor;
+    }
+    return MixHash(netElement->oldColor, netElement->neighborSum % HASH_MOD_2);
+}
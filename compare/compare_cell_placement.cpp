@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "compare_cell.h"
+
+constexpr HASH_VALUE PLACEMENT_COLOR = 542978741ll;
+
+bool CompareCell::ResolveAutomorphismByPlacement() {
+    const std::shared_ptr<Layout> layouts[2] = {_cell1->GetNetlist()->GetLayout(), _cell2->GetNetlist()->GetLayout()};
+    const CELL_NAME cellNames[2] = {_cell1->GetName(), _cell2->GetName()};
+    if (layouts[NETLIST_1] == nullptr || layouts[NETLIST_2] == nullptr) {
+        return false;
+    }
+
+    struct PlacedDevice {
+        double x, y;
+        uint8_t orientation;
+        std::shared_ptr<DeviceElement> deviceElement;
+    };
+    const double tolerance = Config::GetInstance().placementTolerance;
+    uint32_t resolved = 0;
+    for (DeviceBucket* bucket : _automorphismDeviceBuckets) {
+        std::vector<PlacedDevice> sides[2];
+        bool complete = true;
+        for (const std::shared_ptr<DeviceElement>& deviceElement : bucket->graphNodes) {
+            Layout::Placement placement;
+            if (!layouts[deviceElement->netlistId]->FindPlacement(cellNames[deviceElement->netlistId], deviceElement->name, placement)) {
+                complete = false;
+                break;
+            }
+            sides[deviceElement->netlistId].push_back({placement.x, placement.y, placement.orientation, deviceElement});
+        }
+        if (!complete || sides[NETLIST_1].size() != sides[NETLIST_2].size()) {
+            continue;
+        }
+
+        // positions relative to the lower left corner of the bucket, so one layout may be shifted against the other
+        for (std::vector<PlacedDevice>& side : sides) {
+            double minX = std::numeric_limits<double>::max(), minY = std::numeric_limits<double>::max();
+            for (const PlacedDevice& placed : side) {
+                minX = std::min(minX, placed.x);
+                minY = std::min(minY, placed.y);
+            }
+            for (PlacedDevice& placed : side) {
+                placed.x -= minX;
+                placed.y -= minY;
+            }
+        }
+        std::vector<PlacedDevice>& side2 = sides[NETLIST_2];
+        std::sort(side2.begin(), side2.end(), [](const PlacedDevice& a, const PlacedDevice& b) {
+            return a.x < b.x;
+        });
+
+        // a device pairs with the only device of the other side within the tolerance, any doubt leaves the bucket alone
+        std::vector<size_t> partners;
+        std::vector<bool> used(side2.size(), false);
+        for (const PlacedDevice& placed1 : sides[NETLIST_1]) {
+            size_t partner = side2.size(), found = 0;
+            auto it = std::lower_bound(side2.begin(), side2.end(), placed1.x - tolerance, [](const PlacedDevice& placed, double x) {
+                return placed.x < x;
+            });
+            for (; it != side2.end() && it->x <= placed1.x + tolerance; ++it) {
+                if (std::abs(it->y - placed1.y) <= tolerance && it->orientation == placed1.orientation) {
+                    partner = it - side2.begin();
+                    ++found;
+                }
+            }
+            if (found != 1 || used[partner]) {
+                break;
+            }
+            used[partner] = true;
+            partners.emplace_back(partner);
+        }
+        if (partners.size() != sides[NETLIST_1].size()) {
+            continue;
+        }
+
+        for (size_t i = 0; i < partners.size(); ++i) {
+            const HASH_VALUE color = MixHash(MixHash(bucket->newColor, PLACEMENT_COLOR), i + 1);
+            sides[NETLIST_1][i].deviceElement->newColor = color;
+            side2[partners[i]].deviceElement->newColor = color;
+        }
+        ++resolved;
+    }
+
+    CountProfile(COUNTER_PLACEMENT_RESOLUTIONS, resolved);
+    return resolved != 0;
+}
+
+CompareCell::ColorSnapshot CompareCell::SaveColors() const {
+    ColorSnapshot snapshot;
+    snapshot.devices.reserve(_deviceElements.size());
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        snapshot.devices.emplace_back(deviceElement->oldColor, deviceElement->newColor);
+    }
+    snapshot.nets.reserve(_nets.size());
+    for (const auto& it : _nets) {
+        snapshot.nets.push_back({it.second->oldColor, it.second->newColor, it.second->neighborSum});
+    }
+    return snapshot;
+}
+
+void CompareCell::RestoreColors(const ColorSnapshot& snapshot) {
+    for (size_t i = 0; i < _deviceElements.size(); ++i) {
+        std::tie(_deviceElements[i]->oldColor, _deviceElements[i]->newColor) = snapshot.devices[i];
+    }
+    size_t i = 0;
+    for (const auto& it : _nets) {
+        std::tie(it.second->oldColor, it.second->newColor, it.second->neighborSum) = snapshot.nets[i++];
+    }
+    // the same colors give the same buckets and automorphism groups as before the guess
+    AssignBuckets();
+    BucketsCheck();
+}
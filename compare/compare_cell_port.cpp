@@ -0,0 +1,166 @@
+#include "compare_cell.h"
+
+constexpr HASH_VALUE PORT_NET_LABEL_COLOR = 731266823ll;
+
+void CompareCell::RecordPortColors() {
+    // ports whose nets still share a color are the only candidates for symmetric ports
+    for (const std::shared_ptr<Cell>& cell : {_cell1, _cell2}) {
+        std::vector<HASH_VALUE>& portColors = _portColors[cell == _cell1 ? NETLIST_1 : NETLIST_2];
+        portColors.clear();
+        for (const std::shared_ptr<Port>& port : cell->GetPorts()) {
+            const auto it = _nets.find(port->GetNet());
+            portColors.emplace_back(it == _nets.end() ? 0 : it->second->newColor);
+        }
+    }
+}
+
+void CompareCell::SeedPortLabels() {
+    // a port net starts from the labels of its ports, a sum so the order of ports doesn't matter
+    for (const std::shared_ptr<Cell>& cell : {_cell1, _cell2}) {
+        const std::vector<std::shared_ptr<Port> >& ports = cell->GetPorts();
+        for (size_t i = 0; i < ports.size(); ++i) {
+            const auto it = _nets.find(ports[i]->GetNet());
+            if (it == _nets.end()) {
+                continue;
+            }
+            size_t source = i;
+            if (cell == _cell1) {
+                const auto relabel = _portRelabel->find(i);
+                source = relabel == _portRelabel->end() ? i : relabel->second;
+            }
+            const std::shared_ptr<NetElement>& netElement = it->second;
+            netElement->oldColor = (netElement->oldColor + MixHash(PORT_NET_LABEL_COLOR, ports[source]->GetLabel())) % HASH_MOD_2;
+            netElement->newColor = netElement->oldColor;
+        }
+    }
+}
+
+bool CompareCell::ConfirmPortRelabel(const std::unordered_map<size_t, size_t>& relabel) const {
+    // _cell1 with permuted port labels still matches _cell2 only if the permutation is an automorphism of _cell1
+    CountProfile(COUNTER_PORT_CLASS_CHECKS);
+    CompareCell check(_cell1, _cell2);
+    check._portRelabel = &relabel;
+    check._cancelToken = _cancelToken;
+    check.LoadData();
+    return check.Refine() == COMPARE_CELL_TRUE;
+}
+
+bool CompareCell::QuotesSeparate(const std::vector<size_t>& members) const {
+    // a shared pin magic only matters to a parent whose quote wires two members to different nets.
+    // It has to be exported there even when the parent has no symmetry of its own: the other netlist may wire the
+    // members the other way round. Matched parents wire alike, the parents of _cell1 stand for both netlists.
+    for (const std::weak_ptr<Cell>& weakParent : _cell1->_parents) {
+        const std::shared_ptr<Cell> parent = weakParent.lock();
+        if (parent == nullptr) {
+            continue;
+        }
+        const auto sons = parent->_sons.find(_cell1);
+        if (sons == parent->_sons.end()) {
+            continue;
+        }
+        for (const std::shared_ptr<Quote>& quote : sons->second) {
+            // quotes of the parent are usually not devices yet, their pins only sit in _pendingNets
+            std::vector<std::shared_ptr<Net> > pinNets = quote->_pendingNets;
+            if (pinNets.empty()) {
+                for (const auto& [net, pinMagic] : quote->GetConnectNets()) {
+                    pinNets.emplace_back(net);
+                }
+            }
+            std::shared_ptr<Net> firstNet;
+            for (size_t member : members) {
+                if (member >= pinNets.size()) {
+                    continue;
+                }
+                if (firstNet == nullptr) {
+                    firstNet = pinNets[member];
+                } else if (pinNets[member] != firstNet) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+std::unordered_map<PIN_MAGIC, PIN_MAGIC> CompareCell::ConfirmPortClasses(bool quotedElsewhere) const {
+    const std::vector<std::shared_ptr<Port> >& ports = _cell1->GetPorts();
+    std::unordered_map<PIN_MAGIC, PIN_MAGIC> classMagics;
+    // nothing quotes the top cell, its port classes would never be read
+    if (_portColors[NETLIST_1].size() != ports.size() || (_cell1->_parents.empty() && !quotedElsewhere)) {
+        return classMagics;
+    }
+    ScopedTimer timer("ConfirmPortClasses", _cell1->GetName());
+
+    std::unordered_map<HASH_VALUE, std::vector<size_t> > candidates;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        if (_portColors[NETLIST_1][i] != 0 && ports[i]->GetLabel() != PIN_MAGIC_NO_DEFINE) {
+            candidates[_portColors[NETLIST_1][i]].emplace_back(i);
+        }
+    }
+
+    // a rotation and one transposition generate every permutation of a class, so two checks prove it
+    for (const auto& [color, members] : candidates) {
+        if (members.size() < 2 || (!quotedElsewhere && !QuotesSeparate(members))) {
+            continue;
+        }
+        std::unordered_map<size_t, size_t> rotation, transposition;
+        for (size_t k = 0; k < members.size(); ++k) {
+            rotation[members[k]] = members[(k + 1) % members.size()];
+        }
+        transposition[members[0]] = members[1];
+        transposition[members[1]] = members[0];
+        if (!ConfirmPortRelabel(rotation) || (members.size() > 2 && !ConfirmPortRelabel(transposition))) {
+            continue;
+        }
+
+        PIN_MAGIC classMagic = ports[members[0]]->GetLabel();
+        for (size_t member : members) {
+            classMagic = std::min<PIN_MAGIC>(classMagic, ports[member]->GetLabel());
+        }
+        for (size_t member : members) {
+            classMagics[ports[member]->GetLabel()] = classMagic;
+        }
+    }
+    return classMagics;
+}
+
+void CompareCell::ExportPortClasses(bool quotedElsewhere) {
+    // matched ports share a label, so a class confirmed on _cell1 names the same class of _cell2
+    const std::unordered_map<PIN_MAGIC, PIN_MAGIC> confirmed = ConfirmPortClasses(quotedElsewhere);
+
+    for (const std::shared_ptr<Cell>& cell : {_cell1, _cell2}) {
+        const std::vector<std::shared_ptr<Port> >& ports = cell->GetPorts();
+
+        // declared groups and confirmed classes are merged, a port in both joins the two
+        std::vector<size_t> root(ports.size());
+        for (size_t i = 0; i < ports.size(); ++i) {
+            root[i] = i;
+        }
+        auto Find = [&root](size_t i) {
+            while (root[i] != i) {
+                i = root[i] = root[root[i]];
+            }
+            return i;
+        };
+        std::unordered_map<HASH_VALUE, size_t> firstMember;
+        for (size_t i = 0; i < ports.size(); ++i) {
+            const int32_t group = cell->GetPortGroup(i);
+            const auto it = confirmed.find(ports[i]->GetLabel());
+            for (const HASH_VALUE classKey : {group < 0 ? 0 : MixHash(PIN_MAGIC_DECLARED_GROUP, group), it == confirmed.end() ? 0 : it->second}) {
+                if (classKey != 0) {
+                    root[Find(i)] = Find(firstMember.emplace(classKey, i).first->second);
+                }
+            }
+        }
+
+        std::vector<PIN_MAGIC> pinMagics(ports.size(), PIN_MAGIC_NO_DEFINE);
+        for (size_t i = 0; i < ports.size(); ++i) {
+            PIN_MAGIC& classMagic = pinMagics[Find(i)];
+            classMagic = classMagic == PIN_MAGIC_NO_DEFINE ? ports[i]->GetLabel() : std::min<PIN_MAGIC>(classMagic, ports[i]->GetLabel());
+        }
+        for (size_t i = 0; i < ports.size(); ++i) {
+            pinMagics[i] = pinMagics[Find(i)];
+        }
+        cell->SetPortPinMagics(pinMagics);
+    }
+}
@@ -0,0 +1,45 @@
+#include "compare_cell.h"
+
+void CompareCell::CountProfile(const char* counter, int64_t value) const {
+    Profile::GetInstance().Count(_cell1->GetName(), counter, value);
+}
+
+void CompareCell::ProfileBuckets() const {
+    if (!Profile::GetInstance().IsEnabled()) {
+        return;
+    }
+    CountProfile(COUNTER_DEVICE_BUCKETS, _deviceBuckets[_lastBucketsId].size());
+    CountProfile(COUNTER_NET_BUCKETS, _netBuckets[_lastBucketsId].size());
+    CountProfile(COUNTER_AUTOMORPHISM_GROUPS, _automorphismDeviceBuckets.size() + _automorphismNetBuckets.size());
+}
+
+uint64_t CompareCell::AccountMemory() const {
+    MemoryReport& report = MemoryReport::GetInstance();
+
+    uint64_t deviceBytes = _deviceElements.capacity() * sizeof(std::shared_ptr<DeviceElement>);
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        deviceBytes += sizeof(DeviceElement) + deviceElement->_connectNetElements.capacity() * sizeof(std::pair<std::shared_ptr<NetElement>, PIN_MAGIC>);
+    }
+    report.Add("DeviceElement", _deviceElements.size(), deviceBytes);
+
+    uint64_t netBytes = _nets.bucket_count() * sizeof(void*);
+    for (const auto& it : _nets) {
+        netBytes += sizeof(it) + sizeof(NetElement) + it.second->_connectDeviceElements.capacity() * sizeof(std::pair<std::weak_ptr<DeviceElement>, PIN_MAGIC>);
+    }
+    report.Add("NetElement", _nets.size(), netBytes);
+
+    uint64_t bucketBytes = 0, bucketCount = 0;
+    for (int i = 0; i < 2; ++i) {
+        bucketCount += _deviceBuckets[i].size() + _netBuckets[i].size();
+        bucketBytes += (_deviceBuckets[i].bucket_count() + _netBuckets[i].bucket_count()) * sizeof(void*);
+        for (const auto& it : _deviceBuckets[i]) {
+            bucketBytes += sizeof(it) + it.second.graphNodes.capacity() * sizeof(std::shared_ptr<DeviceElement>);
+        }
+        for (const auto& it : _netBuckets[i]) {
+            bucketBytes += sizeof(it) + it.second.graphNodes.capacity() * sizeof(std::shared_ptr<NetElement>);
+        }
+    }
+    report.Add("Bucket", bucketCount, bucketBytes);
+
+    return deviceBytes + netBytes + bucketBytes;
+}
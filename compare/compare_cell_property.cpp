@@ -0,0 +1,19 @@
+#include "compare_cell.h"
+
+void CompareCell::BuildPropertyBins() {
+    _propertyBins.Clear();
+    if (!Config::GetInstance().propertyColoring) {
+        return;
+    }
+
+    for (const std::shared_ptr<DeviceElement>& deviceElement : _deviceElements) {
+        const std::shared_ptr<Device>& device = deviceElement->device;
+        _propertyBins.Add(device->GetDeviceType(), device->GetSizes());
+    }
+    _propertyBins.Build();
+}
+
+HASH_VALUE CompareCell::GetDevicePropertyColor(const std::shared_ptr<DeviceElement>& deviceElement) const {
+    const std::shared_ptr<Device>& device = deviceElement->device;
+    return _propertyBins.GetColor(device->GetDeviceType(), device->GetSizes());
+}
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include "compare_netlist.h"
+#include "../config/config.h"
+
+CompareNetlist::CompareNetlist(std::shared_ptr<Netlist>& netlist1, std::shared_ptr<Netlist>& netlist2): _netlist1(netlist1), _netlist2(netlist2), _orderKey(OUT.GetOrderKey()) {
+    _netlist1->SetID(NETLIST_1);
+    _netlist2->SetID(NETLIST_2);
+}
+
+std::shared_ptr<CompareNetlist::CellElement> CompareNetlist::GetCellELement(const std::shared_ptr<Cell>& cell) const {
+    auto it = _cells1.find(cell);
+    if (it != _cells1.end()) {
+        return it->second;
+    }
+    it = _cells2.find(cell);
+    return it != _cells2.end() ? it->second : nullptr;
+}
+
+void CompareNetlist::LoadCells(const std::shared_ptr<Netlist>& netlist, std::unordered_map<std::shared_ptr<Cell>, std::shared_ptr<CellElement> >& cells) {
+    for (const std::shared_ptr<Cell>& cell : netlist->_validCells) {
+        cells.emplace(cell, std::make_shared<CellElement>(cell));
+    }
+}
+
+void CompareNetlist::BuildTargetCell() {
+    // cells pair by name, a flat compare only pairs the top cells
+    if (Config::GetInstance().hier) {
+        for (const auto& [cell1, cellElement1] : _cells1) {
+            const std::shared_ptr<Cell> cell2 = _netlist2->FindCell(cell1->GetName());
+            const auto it2 = _cells2.find(cell2);
+            if (it2 != _cells2.end()) {
+                cellElement1->targetCell = it2->second;
+                it2->second->targetCell = cellElement1;
+            }
+        }
+    }
+
+    // explicit pairs and the top cells override the pairs by name
+    auto Pair = [](const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2) {
+        if (cellElement1 == nullptr || cellElement2 == nullptr) {
+            return;
+        }
+        for (const std::shared_ptr<CellElement>& cellElement : {cellElement1, cellElement2}) {
+            const std::shared_ptr<CellElement> target = cellElement->targetCell.lock();
+            if (target != nullptr) {
+                target->targetCell.reset();
+            }
+        }
+        cellElement1->targetCell = cellElement2;
+        cellElement2->targetCell = cellElement1;
+    };
+    for (const auto& [cellName1, cellName2] : _pairedCells) {
+        Pair(GetCellELement(_netlist1->FindCell(cellName1)), GetCellELement(_netlist2->FindCell(cellName2)));
+    }
+    Pair(GetCellELement(_netlist1->GetTopCell()), GetCellELement(_netlist2->GetTopCell()));
+}
+
+void CompareNetlist::LoadData() {
+    LoadCells(_netlist1, _cells1);
+    LoadCells(_netlist2, _cells2);
+    BuildTargetCell();
+    ApplyExternalResults(); // pairs compared by worker processes are skipped by HierarchyCompare
+}
+
+void CompareNetlist::FlattenOneQuote(const std::shared_ptr<CellElement>& cellElement, std::shared_ptr<Quote> quote) {
+    ScopedTimer timer("FlattenQuote", quote->GetQuoteCell()->GetName()); // nested in "Flatten", not summed with it
+    const std::shared_ptr<Cell>& parent = cellElement->cell;
+    const std::shared_ptr<Cell> son = quote->GetQuoteCell();
+    const std::shared_ptr<Netlist> netlist = parent->GetNetlist();
+    const std::string prefix = quote->GetName() + "/";
+
+    // ports take the nets of the quote, global nets stay global, the rest become "X1/net"
+    std::unordered_map<std::shared_ptr<Net>, std::shared_ptr<Net> > netMap;
+    for (const auto& it : son->GetNets()) {
+        const std::shared_ptr<Net>& net = it.second;
+        const PORT_INDEX portIndex = net->GetPortIndex();
+        if (portIndex != NOT_PORT && static_cast<size_t>(portIndex) < quote->_pendingNets.size()) {
+            netMap[net] = quote->_pendingNets[portIndex];
+        } else if (netlist != nullptr && netlist->IsGlobalNet(net->GetName())) {
+            netMap[net] = parent->DefineNet(net->GetName());
+        } else {
+            netMap[net] = parent->DefineNet(prefix + net->GetName());
+        }
+    }
+
+    for (const auto& it : son->GetDevices()) {
+        const std::shared_ptr<Device>& device = it.second;
+        const std::shared_ptr<Device> copy = device->CopyDevice(parent, prefix + device->GetName());
+        copy->SetDeviceType(device->GetDeviceType());
+        copy->SetModel(device->GetModel());
+        for (const auto& [net, pinMagic] : device->GetConnectNets()) {
+            copy->AddConnectNet(netMap[net], pinMagic);
+        }
+        parent->AddDevice(copy);
+    }
+
+    parent->GetDevices().erase(quote->GetName());
+    parent->GetQuotes().remove(quote);
+}
+
+void CompareNetlist::QuoteToBeDevice(const std::shared_ptr<Quote>& quote) const {
+    const std::shared_ptr<Cell> son = quote->GetQuoteCell();
+    const std::shared_ptr<CellElement> sonElement = GetCellELement(son);
+    // matched cells of both netlists share the label, so their quotes get the same model
+    quote->SetModel(sonElement != nullptr && !sonElement->label.empty() ? sonElement->label : son->GetName());
+    for (size_t i = 0; i < quote->_pendingNets.size(); ++i) {
+        quote->AddConnectNet(quote->_pendingNets[i], son->GetPortPinMagic(i));
+    }
+}
+
+void CompareNetlist::AtomizeCell(const std::shared_ptr<CellElement>& cellElement) {
+    std::lock_guard<std::mutex> lock(cellElement->atomizeMutex);
+    ScopedTimer timer("Flatten", cellElement->cell->GetName());
+    // FlattenOneQuote edits the quote list
+    const std::vector<std::shared_ptr<Quote> > quotes(cellElement->cell->GetQuotes().begin(), cellElement->cell->GetQuotes().end());
+    for (const std::shared_ptr<Quote>& quote : quotes) {
+        const std::shared_ptr<CellElement> sonElement = GetCellELement(quote->GetQuoteCell());
+        if (sonElement != nullptr && sonElement->flattened) {
+            FlattenOneQuote(cellElement, quote);
+        } else {
+            QuoteToBeDevice(quote);
+        }
+    }
+}
+
+void CompareNetlist::DealCompareCellsTrue(const std::unique_ptr<CompareCell>& compareCell,
+            const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2)
+{
+    cellElement1->matched = cellElement2;
+    cellElement2->matched = cellElement1;
+    cellElement1->label = cellElement2->label = cellElement1->cell->GetName();
+
+    // a port is labeled by the final color of its net, matched ports of both cells share it
+    for (const std::shared_ptr<CellElement>& cellElement : {cellElement1, cellElement2}) {
+        for (const std::shared_ptr<Port>& port : cellElement->cell->GetPorts()) {
+            const auto it = compareCell->_nets.find(port->GetNet());
+            port->SetLabel(it != compareCell->_nets.end() ? it->second->newColor : PIN_MAGIC_NO_DEFINE);
+        }
+    }
+    // ports proven interchangeable share one pin magic, so parents don't resolve that symmetry again
+    compareCell->ExportPortClasses(_topQuoted && cellElement1->cell == _netlist1->GetTopCell());
+}
+
+void CompareNetlist::CellReady(const std::shared_ptr<CellElement>& cellElement) {
+    const std::shared_ptr<CellElement> target = cellElement->targetCell.lock();
+    if (target == nullptr) {
+        _readyCells.emplace(cellElement, nullptr);
+        return;
+    }
+    if (!_waitingCells.erase(target)) {
+        _waitingCells.insert(cellElement);
+        return;
+    }
+    if (_cells1.count(cellElement->cell)) {
+        _readyCells.emplace(cellElement, target);
+    } else {
+        _readyCells.emplace(target, cellElement);
+    }
+}
+
+void CompareNetlist::CellDone(const std::shared_ptr<CellElement>& cellElement) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (const std::weak_ptr<Cell>& weakParent : cellElement->cell->_parents) {
+        const std::shared_ptr<CellElement> parent = GetCellELement(weakParent.lock());
+        if (parent != nullptr && --parent->outDegree == 0) {
+            CellReady(parent);
+        }
+    }
+}
+
+bool CompareNetlist::BreakWaitingCycle() {
+    // the hierarchies nest the paired cells in a different order, one pair can only be flattened
+    if (_waitingCells.empty()) {
+        return false;
+    }
+    const std::shared_ptr<CellElement> cellElement = *_waitingCells.begin();
+    _waitingCells.erase(_waitingCells.begin());
+    const std::shared_ptr<CellElement> target = cellElement->targetCell.lock();
+    if (target != nullptr) {
+        target->targetCell.reset();
+    }
+    cellElement->targetCell.reset();
+    _readyCells.emplace(cellElement, nullptr);
+    return true;
+}
+
+void CompareNetlist::ProcessReadyCells(const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2) {
+    // the report of a cell pair stays together whichever worker runs it
+    const ScopedOrderKey orderKey(_orderKey + "/" + cellElement1->cell->GetName() + (cellElement2 == nullptr ? "" : " " + cellElement2->cell->GetName()));
+    // a doomed or resolved cell only releases its parents, they are doomed or resolved too
+    if (ShouldSkip(cellElement1) || (cellElement2 != nullptr && ShouldSkip(cellElement2))) {
+        CellDone(cellElement1);
+        if (cellElement2 != nullptr) {
+            CellDone(cellElement2);
+        }
+        return;
+    }
+    if (cellElement2 == nullptr) {
+        AtomizeCell(cellElement1);
+        cellElement1->flattened = true;
+        CellDone(cellElement1);
+        return;
+    }
+
+    AtomizeCell(cellElement1);
+    AtomizeCell(cellElement2);
+    const std::unique_ptr<CompareCell> compareCell = std::make_unique<CompareCell>(cellElement1->cell, cellElement2->cell);
+    compareCell->SetCancelToken(&_cancelToken);
+    const COMPARE_CELL_RESULT result = compareCell->Compare();
+    LVS_TRACE(TRACE_CELL, OUT << "cell " << cellElement1->cell->GetName() << " vs " << cellElement2->cell->GetName() << ": "
+        << (result == COMPARE_CELL_TRUE ? "true" : result == COMPARE_CELL_FALSE ? "false" : "cancelled") << std::endl);
+    if (result == COMPARE_CELL_TRUE) {
+        DealCompareCellsTrue(compareCell, cellElement1, cellElement2);
+    } else if (result == COMPARE_CELL_FALSE) {
+        PropagateMismatch(cellElement1, cellElement2, Config::GetInstance().diagnose ? compareCell->Diagnose() : "");
+    }
+    CellDone(cellElement1);
+    CellDone(cellElement2);
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::GetResult() {
+    const std::shared_ptr<CellElement> top1 = GetCellELement(_netlist1->GetTopCell());
+    if (top1 == nullptr || top1->matched.lock() == nullptr) {
+        return COMPARE_NETLIST_FALSE;
+    }
+    return GetMismatchedCells().empty() ? COMPARE_NETLIST_TRUE : COMPARE_NETLIST_FALSE;
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::OneThreadHierarchyCompare() {
+    while (true) {
+        std::pair<std::shared_ptr<CellElement>, std::shared_ptr<CellElement> > ready;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (_cancelToken.IsCancelled() || (_readyCells.empty() && !BreakWaitingCycle())) {
+                break;
+            }
+            ready = _readyCells.front();
+            _readyCells.pop();
+        }
+        ProcessReadyCells(ready.first, ready.second);
+    }
+    return GetResult();
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::MultiThreadHierarchyCompare() {
+    auto Worker = [this]() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        // after a fail-fast cancel the running cells stop at their next iterate and nothing new is popped
+        while (!_cancelToken.IsCancelled()) {
+            if (_readyCells.empty()) {
+                // a running cell may still release its parents
+                if (_runningCells != 0) {
+                    cvQueueNotEmpty.wait(lock);
+                    continue;
+                }
+                if (!BreakWaitingCycle()) {
+                    break;
+                }
+            }
+            const auto ready = _readyCells.front();
+            _readyCells.pop();
+            ++_runningCells;
+            lock.unlock();
+            ProcessReadyCells(ready.first, ready.second);
+            lock.lock();
+            --_runningCells;
+            cvQueueNotEmpty.notify_all();
+        }
+        cvQueueNotEmpty.notify_all();
+    };
+
+    const size_t threadNum = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), _cells1.size()));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threadNum; ++i) {
+        workers.emplace_back(Worker);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return GetResult();
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::HierarchyCompare() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (const auto* cells : {&_cells1, &_cells2}) {
+            for (const auto& it : *cells) {
+                if (it.second->outDegree == 0) {
+                    CellReady(it.second);
+                }
+            }
+        }
+    }
+    return Config::GetInstance().multiThread ? MultiThreadHierarchyCompare() : OneThreadHierarchyCompare();
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::FullFlattenCompare() {
+    // BuildTargetCell left only the top cells paired, every other cell is flattened bottom-up
+    return HierarchyCompare();
+}
+
+COMPARE_NETLIST_RESULT CompareNetlist::Compare() {
+    ScopedTimer timer("CompareNetlist");
+    LoadData();
+    return Config::GetInstance().hier ? HierarchyCompare() : FullFlattenCompare();
+}
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <queue>
+#include <unordered_set>
 #include <thread>
 #include <mutex>
 #include <atomic>
@@ -11,6 +12,13 @@
 class CompareNetlist {
     private:
         friend class CompareCell;
+    public:
+        // verdict and port labels of one cell pair compared in another process, see ProcessCompare
+        struct ExternalResult {
+            CELL_NAME cellName1, cellName2;
+            COMPARE_CELL_RESULT result;
+            std::vector<PIN_MAGIC> portPinMagics1, portPinMagics2; // Cell::GetPortPinMagic of every port
+        };
     private:
         struct CellElement;
         struct SimilarCell {
@@ -29,9 +37,13 @@ class CompareNetlist {
             std::weak_ptr<CellElement> matched;
             DEVICE_MODEL_NAME label;
             std::mutex atomizeMutex;
+            std::atomic<bool> doomed; // a descendant mismatched, the compare of this cell is skipped
+            std::atomic<bool> resolved; // compared by a worker process, skipped but still releases its parents
             CellElement(const std::shared_ptr<Cell>& cell_): cell(cell_) {
                 outDegree = cell_->_outDegree;
                 flattened = false;
+                doomed = false;
+                resolved = false;
             }
         };
     private:
@@ -39,7 +51,22 @@ class CompareNetlist {
         std::mutex queueMutex;
         std::condition_variable cvQueueNotEmpty;
         std::shared_ptr<Netlist> _netlist1, _netlist2;
+        std::string _orderKey; // OUT key of the caller, prefix of the key of every cell pair
         std::unordered_map<std::shared_ptr<Cell>, std::shared_ptr<CellElement> > _cells1, _cells2;
+
+        CancelToken _cancelToken; // fail fast, polled by workers and by every CompareCell
+        std::mutex _mismatchMutex;
+        std::vector<std::pair<CELL_NAME, CELL_NAME> > _mismatchedCells; // cells that mismatched themselves, not doomed ones
+        std::map<std::pair<CELL_NAME, CELL_NAME>, std::string> _diagnoses; // CompareCell::Diagnose of mismatched cells
+
+        std::vector<ExternalResult> _externalResults; // applied by LoadData once the cell elements exist
+        std::vector<std::pair<CELL_NAME, CELL_NAME> > _pairedCells; // paired by BuildTargetCell whatever their names
+        bool _topQuoted = false; // the top cells are quoted in a netlist this compare doesn't see, see SetTopQuoted
+
+        // bottom-up schedule, guarded by queueMutex: a pair is compared, a cell without target is flattened
+        std::queue<std::pair<std::shared_ptr<CellElement>, std::shared_ptr<CellElement> > > _readyCells;
+        std::unordered_set<std::shared_ptr<CellElement> > _waitingCells; // ready, their target cell is not yet
+        size_t _runningCells{0};
     private:
         void LoadData();
         void LoadCells(const std::shared_ptr<Netlist>& netlist, std::unordered_map<std::shared_ptr<Cell>, std::shared_ptr<CellElement> >& cells);
@@ -50,12 +77,40 @@ class CompareNetlist {
         COMPARE_NETLIST_RESULT MultiThreadHierarchyCompare();
         void AtomizeCell(const std::shared_ptr<CellElement>& cellElement); // flatten all quotes
         void FlattenOneQuote(const std::shared_ptr<CellElement>& cellElement, std::shared_ptr<Quote> quote);
-        void QuoteToBeDevice(const std::shared_ptr<Quote>& quote) const;
+        void QuoteToBeDevice(const std::shared_ptr<Quote>& quote) const; // pins take Cell::GetPortPinMagic of the quoted cell
         void DealCompareCellsTrue(const std::unique_ptr<CompareCell>& compareCell,
                     const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2);
 
         std::shared_ptr<CellElement> GetCellELement(const std::shared_ptr<Cell>& cell) const;
+
+        void CellReady(const std::shared_ptr<CellElement>& cellElement); // all sons done, queueMutex held
+        void CellDone(const std::shared_ptr<CellElement>& cellElement); // releases the parents
+        bool BreakWaitingCycle(); // nothing runs but cells wait: unpair one, queueMutex held
+        void ProcessReadyCells(const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2);
+        COMPARE_NETLIST_RESULT GetResult();
+
+        // workers call ShouldSkip before flattening or comparing a popped cell, and PropagateMismatch on COMPARE_CELL_FALSE,
+        // passing compareCell->Diagnose() when Config::diagnose is on
+        void PropagateMismatch(const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2,
+            const std::string& diagnosis = "");
+        bool ShouldSkip(const std::shared_ptr<CellElement>& cellElement) const;
+        void ApplyExternalResults(); // end of LoadData, after BuildTargetCell
     public:
         CompareNetlist(std::shared_ptr<Netlist>& netlist1, std::shared_ptr<Netlist>& netlist2);
         COMPARE_NETLIST_RESULT Compare();
+        COMPARE_CELL_RESULT GetCellResult(const CELL_NAME& cellName1) const; // after Compare, by the name in netlist1
+        std::vector<std::pair<CELL_NAME, CELL_NAME> > GetMismatchedCells();
+        std::string GetDiagnosis(const CELL_NAME& cellName1, const CELL_NAME& cellName2); // empty if not diagnosed
+        // before Compare: cells compared elsewhere, their port labels are set on the cells right away
+        void AddExternalResult(const ExternalResult& result);
+        void PairCells(const CELL_NAME& cellName1, const CELL_NAME& cellName2) { // before Compare, e.g. top cells named differently
+            _pairedCells.emplace_back(cellName1, cellName2);
+        }
+        std::vector<ExternalResult> ExportResults(); // after Compare: every matched or mismatched pair
+        void SetTopQuoted() { // before Compare, e.g. a ProcessCompare job: port classes of the top cells are exported too
+            _topQuoted = true;
+        }
+        void Cancel() {
+            _cancelToken.Cancel();
+        }
 };
\ No newline at end of file
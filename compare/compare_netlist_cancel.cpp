@@ -0,0 +1,46 @@
+#include "compare_netlist.h"
+#include "../config/config.h"
+
+void CompareNetlist::PropagateMismatch(const std::shared_ptr<CellElement>& cellElement1, const std::shared_ptr<CellElement>& cellElement2,
+    const std::string& diagnosis)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mismatchMutex);
+        _mismatchedCells.emplace_back(cellElement1->cell->GetName(), cellElement2->cell->GetName());
+        if (!diagnosis.empty()) {
+            _diagnoses[_mismatchedCells.back()] = diagnosis;
+        }
+    }
+    if (Config::GetInstance().failFast) {
+        _cancelToken.Cancel();
+        return;
+    }
+
+    // every ancestor can't match any more, independent subtrees go on
+    std::vector<std::shared_ptr<CellElement> > stack = {cellElement1, cellElement2};
+    while (!stack.empty()) {
+        const std::shared_ptr<CellElement> cellElement = stack.back();
+        stack.pop_back();
+        for (const std::weak_ptr<Cell>& weakParent : cellElement->cell->_parents) {
+            const std::shared_ptr<CellElement> parent = GetCellELement(weakParent.lock());
+            if (parent != nullptr && !parent->doomed.exchange(true)) {
+                stack.emplace_back(parent);
+            }
+        }
+    }
+}
+
+bool CompareNetlist::ShouldSkip(const std::shared_ptr<CellElement>& cellElement) const {
+    return _cancelToken.IsCancelled() || cellElement->doomed.load() || cellElement->resolved.load();
+}
+
+std::string CompareNetlist::GetDiagnosis(const CELL_NAME& cellName1, const CELL_NAME& cellName2) {
+    std::lock_guard<std::mutex> lock(_mismatchMutex);
+    const auto it = _diagnoses.find({cellName1, cellName2});
+    return it != _diagnoses.end() ? it->second : std::string();
+}
+
+std::vector<std::pair<CELL_NAME, CELL_NAME> > CompareNetlist::GetMismatchedCells() {
+    std::lock_guard<std::mutex> lock(_mismatchMutex);
+    return _mismatchedCells;
+}
@@ -0,0 +1,57 @@
+#include "compare_netlist.h"
+
+static std::vector<PIN_MAGIC> GetPortPinMagics(const std::shared_ptr<Cell>& cell) {
+    std::vector<PIN_MAGIC> pinMagics;
+    for (size_t i = 0; i < cell->GetPorts().size(); ++i) {
+        pinMagics.emplace_back(cell->GetPortPinMagic(i));
+    }
+    return pinMagics;
+}
+
+void CompareNetlist::AddExternalResult(const ExternalResult& result) {
+    const std::shared_ptr<Cell> cell1 = _netlist1->FindCell(result.cellName1);
+    const std::shared_ptr<Cell> cell2 = _netlist2->FindCell(result.cellName2);
+    if (cell1 == nullptr || cell2 == nullptr) {
+        return;
+    }
+    // parents quote these cells as devices, their pins need the labels before any parent is compared
+    if (result.result == COMPARE_CELL_TRUE) {
+        cell1->SetPortPinMagics(result.portPinMagics1);
+        cell2->SetPortPinMagics(result.portPinMagics2);
+    }
+    _externalResults.emplace_back(result);
+}
+
+void CompareNetlist::ApplyExternalResults() {
+    for (const ExternalResult& result : _externalResults) {
+        const std::shared_ptr<CellElement> cellElement1 = GetCellELement(_netlist1->FindCell(result.cellName1));
+        const std::shared_ptr<CellElement> cellElement2 = GetCellELement(_netlist2->FindCell(result.cellName2));
+        if (cellElement1 == nullptr || cellElement2 == nullptr || cellElement1->resolved.exchange(true)) {
+            continue; // outside the hierarchy, or a shared subcell another worker reported already
+        }
+        cellElement2->resolved = true;
+        if (result.result == COMPARE_CELL_TRUE) {
+            cellElement1->matched = cellElement2;
+            cellElement2->matched = cellElement1;
+            cellElement1->label = cellElement2->label = result.cellName1;
+        } else {
+            PropagateMismatch(cellElement1, cellElement2);
+        }
+    }
+    _externalResults.clear();
+}
+
+std::vector<CompareNetlist::ExternalResult> CompareNetlist::ExportResults() {
+    std::vector<ExternalResult> results;
+    for (const auto& it : _cells1) {
+        const std::shared_ptr<CellElement> matched = it.second->matched.lock();
+        if (matched != nullptr) {
+            results.push_back({it.first->GetName(), matched->cell->GetName(), COMPARE_CELL_TRUE,
+                GetPortPinMagics(it.first), GetPortPinMagics(matched->cell)});
+        }
+    }
+    for (const auto& [cellName1, cellName2] : GetMismatchedCells()) {
+        results.push_back({cellName1, cellName2, COMPARE_CELL_FALSE, {}, {}});
+    }
+    return results;
+}
@@ -0,0 +1,10 @@
+#include "compare_netlist.h"
+
+COMPARE_CELL_RESULT CompareNetlist::GetCellResult(const CELL_NAME& cellName1) const {
+    const std::shared_ptr<Cell> cell = _netlist1->FindCell(cellName1);
+    if (cell == nullptr) {
+        return COMPARE_CELL_FALSE;
+    }
+    const std::shared_ptr<CellElement> cellElement = GetCellELement(cell);
+    return cellElement != nullptr && cellElement->matched.lock() != nullptr ? COMPARE_CELL_TRUE : COMPARE_CELL_FALSE;
+}
@@ -0,0 +1,366 @@
+#include <chrono>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "compare_service.h"
+#include "out_of_core_compare.h"
+#include "process_compare.h"
+#include "../base/profile.h"
+#include "../parse/incremental_loader.h"
+#include "../parse/library_cache.h"
+
+static std::map<std::string, std::string> ParseFields(const std::string& request) {
+    std::map<std::string, std::string> fields;
+    std::istringstream in(request);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const size_t space = line.find(' ');
+        if (space != std::string::npos) {
+            fields[line.substr(0, space)] = line.substr(space + 1);
+        }
+    }
+    return fields;
+}
+
+static bool ConnectOrBind(const std::string& socketPath, int& fd, bool bindSocket) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    socketPath.copy(address.sun_path, socketPath.size());
+    const int state = bindSocket ? bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+        : connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (state != 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+static bool WriteAll(int fd, const std::string& data) {
+    for (size_t written = 0; written < data.size(); ) {
+        const ssize_t count = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (count < 0 && errno != EINTR) {
+            return false;
+        }
+        written += std::max<ssize_t>(count, 0);
+    }
+    return true;
+}
+
+CompareService::CompareService(const std::string& socketPath): _socketPath(socketPath) {}
+
+CompareService::~CompareService() {
+    if (_listenFd >= 0) {
+        close(_listenFd);
+        unlink(_socketPath.c_str());
+    }
+}
+
+bool CompareService::Start() {
+    _baseConfig = Config::GetInstance();
+    unlink(_socketPath.c_str()); // left over by a server that was killed
+    if (!ConnectOrBind(_socketPath, _listenFd, true) || listen(_listenFd, 16) != 0) {
+        return false;
+    }
+    _running = true;
+    return true;
+}
+
+bool CompareService::GetStamp(const std::string& file, FILE_STAMP& stamp) {
+    std::error_code error;
+    stamp.first = std::filesystem::last_write_time(file, error);
+    if (!error) {
+        stamp.second = std::filesystem::file_size(file, error);
+    }
+    return !error;
+}
+
+bool CompareService::IsWarm(const WarmNetlist& warm) {
+    if (warm.netlist == nullptr) {
+        return false;
+    }
+    for (const auto& [file, stamp] : warm.stamps) {
+        FILE_STAMP current;
+        if (!GetStamp(file, current) || current != stamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+READ_STATE CompareService::Refresh(WarmNetlist& warm, const std::string& file, const CELL_NAME& topCell,
+    const std::string& scopePath, bool& reloaded)
+{
+    reloaded = false;
+    if (warm.file == file && warm.topCell == topCell && warm.scopePath == scopePath && IsWarm(warm)) {
+        return READ_OK;
+    }
+
+    ScopedTimer timer("ServiceReload", file);
+    // stamps are taken before the parse, an edit during the parse shows up on the next request
+    std::vector<std::pair<std::string, FILE_STAMP> > stamps;
+    auto Stamp = [&stamps](const std::string& stampFile) {
+        FILE_STAMP stamp;
+        if (!GetStamp(stampFile, stamp)) {
+            return false;
+        }
+        stamps.emplace_back(stampFile, stamp);
+        return true;
+    };
+    if (!Stamp(file)) {
+        return NO_FILE;
+    }
+
+    // IncrementalLoader patches its cache in place and hands out a clone, so the reload costs the edit and one copy
+    std::shared_ptr<Netlist> netlist;
+    READ_STATE readState = IncrementalLoader::GetInstance().Load(file, topCell, netlist);
+    if (readState == INCLUDE_FOUND) {
+        // the included files are known once the main file is read, they are stamped before their own parse
+        readState = LibraryCache::GetInstance().Load(file, topCell, netlist, [&Stamp](const IncludeGraph& graph) {
+            for (size_t i = 1; i < graph.GetFiles().size(); ++i) {
+                if (!Stamp(graph.GetFiles()[i].path)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+    if (readState != READ_OK) {
+        return readState;
+    }
+    warm.layout = nullptr;
+    if (Config::GetInstance().placementColoring) {
+        const std::shared_ptr<Layout> layout = std::make_shared<Layout>();
+        if (layout->Read(file)) {
+            warm.layout = layout;
+        }
+    }
+
+    warm.file = file;
+    warm.topCell = topCell;
+    warm.scopePath = scopePath;
+    warm.stamps = std::move(stamps);
+    warm.netlist = netlist;
+    ++warm.loads;
+    reloaded = true;
+    return READ_OK;
+}
+
+READ_STATE CompareService::Checkout(const WarmNetlist& warm, std::shared_ptr<Netlist>& netlist) {
+    // the compare flattens cells in place, Prepare and Freeze too
+    if ((netlist = warm.netlist->Clone()) == nullptr) {
+        return HIERARCHY_LOOP;
+    }
+    READ_STATE readState = READ_OK;
+    if (!warm.topCell.empty() && !MatchNoCase(netlist->GetTopCell()->GetName(), warm.topCell)) {
+        readState = netlist->SetTopCell(warm.topCell); // both sides share the cache of one file
+    }
+    if (readState == READ_OK && !warm.scopePath.empty()) {
+        readState = netlist->ScopeToInstancePath(warm.scopePath);
+    }
+    if (readState != READ_OK) {
+        return readState;
+    }
+    if (warm.layout != nullptr) {
+        netlist->SetLayout(warm.layout);
+    }
+    netlist->Prepare();
+    if (Config::GetInstance().freeze) {
+        netlist->Freeze();
+    }
+    return READ_OK;
+}
+
+bool CompareService::ApplyOptions(const std::map<std::string, std::string>& fields, std::string& error) {
+    Config& config = Config::GetInstance();
+    config = _baseConfig;
+    try {
+        for (const auto& [key, value] : fields) {
+            if (key == "hier") {
+                config.hier = std::stoi(value) != 0;
+            } else if (key == "failFast") {
+                config.failFast = std::stoi(value) != 0;
+            } else if (key == "multiThread") {
+                config.multiThread = std::stoi(value) != 0;
+            } else if (key == "processNum") {
+                config.processNum = std::stoul(value);
+            } else if (key == "memoryBudgetMB") {
+                config.memoryBudgetMB = std::stoull(value);
+            } else if (key == "tolerance") {
+                config.tolerance = std::stod(value);
+            } else if (key == "globalNets") {
+                config.globalNets = SplitString(value, ',');
+            } else if (key == "pinSwap" && !AddPinSwapGroups(value)) {
+                error = "bad pinSwap \"" + value + "\"";
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        error = "bad option value";
+        return false;
+    }
+    return true;
+}
+
+std::string CompareService::Compare(const std::map<std::string, std::string>& fields) {
+    const auto start = std::chrono::steady_clock::now();
+    std::ostringstream reply;
+    std::string error;
+    if (!ApplyOptions(fields, error)) {
+        return "result error\nerror " + error + "\n";
+    }
+    const Config& config = Config::GetInstance();
+
+    // missing keys keep the previous request, or the server start
+    auto Get = [&](const char* key, const std::string& previous, const std::string& base) {
+        const auto it = fields.find(key);
+        return it != fields.end() ? it->second : previous.empty() ? base : previous;
+    };
+    const std::string files[2] = {Get("file1", _warm[0].file, _baseConfig.file1), Get("file2", _warm[1].file, _baseConfig.file2)};
+    const CELL_NAME topCells[2] = {Get("top1", _warm[0].topCell, _baseConfig.topCell1), Get("top2", _warm[1].topCell, _baseConfig.topCell2)};
+    const std::string scopePaths[2] = {fields.count("scope1") ? fields.at("scope1") : _warm[0].scopePath,
+        fields.count("scope2") ? fields.at("scope2") : _warm[1].scopePath};
+
+    std::string reloaded;
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        bool sideReloaded = false;
+        const READ_STATE readState = Refresh(_warm[id], files[id], topCells[id], scopePaths[id], sideReloaded);
+        if (readState != READ_OK) {
+            return "result error\nerror read " + files[id] + " state " + std::to_string(static_cast<int16_t>(readState)) + "\n";
+        }
+        if (sideReloaded) {
+            reloaded += " netlist" + std::to_string(id + 1);
+        }
+    }
+
+    std::ostringstream key;
+    for (const WarmNetlist& warm : _warm) {
+        key << warm.file << ":" << warm.topCell << ":" << warm.scopePath << ":" << warm.loads << ";";
+    }
+    key << config.hier << config.failFast << config.processNum << ":" << config.memoryBudgetMB << ":" << config.tolerance << ":"
+        << (fields.count("pinSwap") ? fields.at("pinSwap") : "") << ":" << (fields.count("globalNets") ? fields.at("globalNets") : "");
+
+    if (key.str() != _lastResult.key) {
+        std::shared_ptr<Netlist> netlists[2];
+        for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+            const READ_STATE readState = Checkout(_warm[id], netlists[id]);
+            if (readState != READ_OK) {
+                return "result error\nerror checkout " + files[id] + " state " + std::to_string(static_cast<int16_t>(readState)) + "\n";
+            }
+        }
+        std::shared_ptr<Netlist>& netlist1 = netlists[NETLIST_1];
+        std::shared_ptr<Netlist>& netlist2 = netlists[NETLIST_2];
+        _lastResult.key.clear();
+        _lastResult.mismatchedCells.clear();
+        if (!config.hier && config.memoryBudgetMB > 0) {
+            OutOfCoreCompare cmp(netlist1, netlist2);
+            _lastResult.result = cmp.Compare();
+        } else {
+            CompareNetlist cmp(netlist1, netlist2);
+            if (config.hier && config.processNum > 0) {
+                ProcessCompare processCompare(netlist1, netlist2, cmp);
+                processCompare.Run();
+            }
+            _lastResult.result = cmp.Compare();
+            _lastResult.mismatchedCells = cmp.GetMismatchedCells();
+        }
+        _lastResult.key = key.str();
+    } else {
+        ++_cachedReplies;
+        reloaded += " cached";
+    }
+
+    reply << "result " << (_lastResult.result == COMPARE_NETLIST_TRUE ? "true"
+        : _lastResult.result == COMPARE_NETLIST_INCONCLUSIVE ? "inconclusive" : "false") << "\n";
+    for (const auto& [cellName1, cellName2] : _lastResult.mismatchedCells) {
+        reply << "mismatch " << cellName1 << " " << cellName2 << "\n";
+    }
+    reply << "reloaded" << (reloaded.empty() ? " none" : reloaded) << "\n";
+    reply << "seconds " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "\n";
+    return reply.str();
+}
+
+std::string CompareService::Handle(const std::string& request) {
+    ++_requests;
+    const std::map<std::string, std::string> fields = ParseFields(request);
+    const auto command = fields.find("command");
+    if (command == fields.end()) {
+        // the OUT report of a request goes back with its reply, nothing piles up across requests
+        std::string reply = Compare(fields);
+        std::istringstream report(LogCollector::GetInstance().Flush());
+        for (std::string line; std::getline(report, line);) {
+            reply += "log " + line + "\n";
+        }
+        return reply;
+    }
+    if (command->second == "shutdown") {
+        _running = false;
+        return "result true\n";
+    }
+    if (command->second == "stats") {
+        std::ostringstream reply;
+        reply << "result true\nrequests " << _requests << "\ncached " << _cachedReplies << "\n";
+        for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+            reply << "netlist" << id + 1 << " " << _warm[id].file << " loads " << _warm[id].loads << "\n";
+        }
+        reply << "reparsedCells " << IncrementalLoader::GetInstance().GetReparsedCells()
+            << "\nlibraryHits " << LibraryCache::GetInstance().GetHits() << "\n";
+        return reply.str();
+    }
+    return "result error\nerror unknown command " + command->second + "\n";
+}
+
+void CompareService::Serve() {
+    while (_running) {
+        const int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // requests are small, read until the empty line or until the client shuts down its side
+        std::string request;
+        char buffer[4096];
+        ssize_t count;
+        while (request.find("\n\n") == std::string::npos && (count = read(fd, buffer, sizeof(buffer))) != 0) {
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            request.append(buffer, count);
+        }
+        WriteAll(fd, Handle(request));
+        close(fd);
+    }
+}
+
+bool CompareService::Request(const std::string& socketPath, const std::string& request, std::string& reply) {
+    int fd;
+    if (!ConnectOrBind(socketPath, fd, false)) {
+        return false;
+    }
+    const bool sent = WriteAll(fd, request + "\n");
+    shutdown(fd, SHUT_WR);
+    char buffer[4096];
+    ssize_t count;
+    while (sent && (count = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        reply.append(buffer, count);
+    }
+    close(fd);
+    return sent;
+}
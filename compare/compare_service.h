@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include "compare_netlist.h"
+
+// Long-running compare server on a Unix socket. Each side keeps its last parsed netlist; a request
+// prepares and compares clones of them, and a side is only loaded again when the file, its top
+// cell or scope, or the stamp of the file or any file it includes changed. Reloads go through
+// IncrementalLoader (only edited .SUBCKT blocks are parsed) or LibraryCache (only edited includes).
+// The last result is kept too, so a request with nothing changed is answered without a compare.
+//
+// One request per connection, "key value" lines ended by an empty line or EOF:
+//   file1, top1, scope1, file2, top2, scope2 - missing keys keep the value of the previous request
+//   hier, failFast, multiThread, processNum, memoryBudgetMB, tolerance, pinSwap, globalNets - this request only
+//   command shutdown|stats
+// The reply is "key value" lines, starting with "result true|false|inconclusive|error".
+// Parse options (caseInsensitive, gateLevel, ...) are those of the server start.
+class CompareService {
+    private:
+        typedef std::pair<std::filesystem::file_time_type, uintmax_t> FILE_STAMP; // mtime, size
+        struct WarmNetlist {
+            std::string file;
+            CELL_NAME topCell;
+            std::string scopePath;
+            std::vector<std::pair<std::string, FILE_STAMP> > stamps; // the file and everything it includes
+            std::shared_ptr<Netlist> netlist; // as loaded, may be the cache of the loader, never prepared or compared
+            std::shared_ptr<Layout> layout; // Config::placementColoring only
+            uint32_t loads{0};
+        };
+        struct CachedResult {
+            std::string key; // stamps, top cells and options of the request
+            COMPARE_NETLIST_RESULT result{COMPARE_NETLIST_FALSE};
+            std::vector<std::pair<CELL_NAME, CELL_NAME> > mismatchedCells;
+        };
+        std::string _socketPath;
+        int _listenFd{-1};
+        bool _running{false};
+        Config _baseConfig;
+        WarmNetlist _warm[2];
+        CachedResult _lastResult;
+        uint64_t _requests{0}, _cachedReplies{0};
+    private:
+        static bool GetStamp(const std::string& file, FILE_STAMP& stamp);
+        static bool IsWarm(const WarmNetlist& warm);
+        READ_STATE Refresh(WarmNetlist& warm, const std::string& file, const CELL_NAME& topCell, const std::string& scopePath,
+            bool& reloaded);
+        static READ_STATE Checkout(const WarmNetlist& warm, std::shared_ptr<Netlist>& netlist); // a prepared clone to compare
+        bool ApplyOptions(const std::map<std::string, std::string>& fields, std::string& error);
+        std::string Compare(const std::map<std::string, std::string>& fields);
+        std::string Handle(const std::string& request);
+    public:
+        explicit CompareService(const std::string& socketPath);
+        CompareService(const CompareService&) = delete;
+        CompareService& operator= (const CompareService&) = delete;
+        ~CompareService();
+
+        bool Start(); // Config at this point is the base of every request
+        void Serve(); // until a shutdown request
+        static bool Request(const std::string& socketPath, const std::string& request, std::string& reply); // client side
+};
@@ -0,0 +1,163 @@
+#include "flat_graph.h"
+#include "../base/profile.h"
+
+FlatGraph::FlatGraph(const std::shared_ptr<Netlist>& netlist, const std::string& directory, size_t partitionBytes):
+    _netlist(netlist), _partitionBytes(partitionBytes),
+    _devices(directory), _devicePins(directory), _netOffsets(directory), _netPins(directory) {}
+
+uint64_t FlatGraph::GetId(uint64_t* slot) {
+    if (*slot == NO_NET) {
+        *slot = _netNum++;
+    }
+    return *slot;
+}
+
+void FlatGraph::FlattenCell(const std::shared_ptr<Cell>& cell, const std::vector<uint64_t*>& portSlots) {
+    // nets get an id when a device pin first touches them, so floating nets never enter the graph
+    std::unordered_map<Net*, uint64_t> localIds;
+    auto GetSlot = [&](const std::shared_ptr<Net>& net) -> uint64_t* {
+        const PORT_INDEX index = net->GetPortIndex();
+        if (index != NOT_PORT && static_cast<size_t>(index) < portSlots.size()) {
+            return portSlots[index];
+        }
+        if (_netlist->IsGlobalNet(net->GetName())) {
+            return &_globalIds.try_emplace(net->GetName(), NO_NET).first->second;
+        }
+        return &localIds.try_emplace(net.get(), NO_NET).first->second;
+    };
+
+    for (const auto& it : cell->GetDevices()) {
+        const std::shared_ptr<Device>& device = it.second;
+        if (device->GetDeviceType() == DEVICE_TYPE_QUOTE) {
+            const std::shared_ptr<Quote> quote = std::dynamic_pointer_cast<Quote>(device);
+            std::vector<uint64_t*> sonSlots;
+            if (!quote->_pendingNets.empty()) {
+                for (const std::shared_ptr<Net>& net : quote->_pendingNets) {
+                    sonSlots.emplace_back(GetSlot(net));
+                }
+            } else {
+                for (const auto& pin : quote->GetConnectNets()) {
+                    sonSlots.emplace_back(GetSlot(pin.first));
+                }
+            }
+            FlattenCell(quote->GetQuoteCell(), sonSlots);
+            continue;
+        }
+
+        for (const auto& pin : device->GetConnectNets()) {
+            _ok = _devicePins.Append(FlatPin{GetId(GetSlot(pin.first)), pin.second}) && _ok;
+        }
+        _ok = _devices.Append(FlatDevice{_devicePins.GetSize() / sizeof(FlatPin), device.get()}) && _ok;
+        ++_deviceNum;
+
+        // written pages are not read again before BuildNetPins
+        if (_devicePins.GetSize() - _releasedPins > _partitionBytes) {
+            _devicePins.Release(_releasedPins, _devicePins.GetSize());
+            _devices.ReleaseAll();
+            _releasedPins = _devicePins.GetSize();
+        }
+    }
+}
+
+void FlatGraph::BuildNetPins() {
+    // counting sort of all device pins by net, the cursors are the only per net state
+    std::vector<uint64_t> cursors(_netNum + 1, 0);
+    const FlatPin* devicePins = GetDevicePins();
+    ForEachDevicePartition([&](uint64_t begin, uint64_t end) {
+        for (uint64_t pin = GetPinBegin(begin); pin < GetDevices()[end - 1].pinEnd; ++pin) {
+            ++cursors[devicePins[pin].id + 1];
+        }
+    });
+    for (uint64_t net = 0; net < _netNum; ++net) {
+        cursors[net + 1] += cursors[net];
+    }
+
+    if (!_netOffsets.Resize((_netNum + 1) * sizeof(uint64_t)) || !_netPins.Resize(cursors[_netNum] * sizeof(FlatPin))) {
+        _ok = false;
+        return;
+    }
+    std::copy(cursors.begin(), cursors.end(), _netOffsets.As<uint64_t>());
+    _netOffsets.ReleaseAll();
+
+    FlatPin* netPins = _netPins.As<FlatPin>();
+    ForEachDevicePartition([&](uint64_t begin, uint64_t end) {
+        for (uint64_t device = begin; device < end; ++device) {
+            for (uint64_t pin = GetPinBegin(device); pin < GetDevices()[device].pinEnd; ++pin) {
+                netPins[cursors[devicePins[pin].id]++] = FlatPin{device, devicePins[pin].pinMagic};
+            }
+        }
+        _netPins.ReleaseAll(); // scattered writes, nothing of it is worth keeping
+    });
+}
+
+bool FlatGraph::Build() {
+    ScopedTimer timer("FlattenToScratch", _netlist->GetTopCell()->GetName());
+    if (!_devices.IsOpen() || !_devicePins.IsOpen() || !_netOffsets.IsOpen() || !_netPins.IsOpen()) {
+        return false;
+    }
+
+    const std::shared_ptr<Cell> topCell = _netlist->GetTopCell();
+    std::vector<uint64_t> topIds(topCell->GetPorts().size(), NO_NET);
+    std::vector<uint64_t*> topSlots;
+    for (uint64_t& id : topIds) {
+        topSlots.emplace_back(&id);
+    }
+    FlattenCell(topCell, topSlots);
+
+    for (size_t i = 0; i < topIds.size(); ++i) {
+        if (topIds[i] != NO_NET) {
+            _namedNets.emplace_back(topIds[i], topCell->GetPorts()[i]->GetName());
+        }
+    }
+    for (const auto& it : _globalIds) {
+        if (it.second != NO_NET) {
+            _namedNets.emplace_back(it.second, it.first);
+        }
+    }
+    decltype(_globalIds)().swap(_globalIds);
+
+    if (_ok && _deviceNum > 0) {
+        BuildNetPins();
+    }
+    return _ok;
+}
+
+void FlatGraph::SetPartitionBytes(size_t partitionBytes) {
+    _partitionBytes = partitionBytes;
+}
+
+uint64_t FlatGraph::GetDeviceNum() const {
+    return _deviceNum;
+}
+
+uint64_t FlatGraph::GetNetNum() const {
+    return _netNum;
+}
+
+const std::vector<std::pair<uint64_t, NET_NAME> >& FlatGraph::GetNamedNets() const {
+    return _namedNets;
+}
+
+size_t FlatGraph::GetScratchBytes() const {
+    return _devices.GetSize() + _devicePins.GetSize() + _netOffsets.GetSize() + _netPins.GetSize();
+}
+
+const FlatGraph::FlatDevice* FlatGraph::GetDevices() const {
+    return _devices.As<FlatDevice>();
+}
+
+const FlatGraph::FlatPin* FlatGraph::GetDevicePins() const {
+    return _devicePins.As<FlatPin>();
+}
+
+uint64_t FlatGraph::GetPinBegin(uint64_t deviceId) const {
+    return deviceId == 0 ? 0 : GetDevices()[deviceId - 1].pinEnd;
+}
+
+const uint64_t* FlatGraph::GetNetOffsets() const {
+    return _netOffsets.As<uint64_t>();
+}
+
+const FlatGraph::FlatPin* FlatGraph::GetNetPins() const {
+    return _netPins.As<FlatPin>();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include "../base/mapped_file.h"
+#include "../netlist/netlist.h"
+
+// Fully flattened device/net graph of one netlist in CSR form, spilled to MappedFile scratch files.
+// Devices and their pins are written during the hierarchy walk, the net side is derived from them.
+// Callers walk it with ForEachDevicePartition/ForEachNetPartition, which release every partition
+// after the visit, so only about one partition of it stays resident.
+class FlatGraph {
+    public:
+        struct FlatDevice {
+            uint64_t pinEnd; // pins of device d are [pinEnd of d - 1, pinEnd of d)
+            Device* device; // the hierarchical device, alive as long as the netlist
+        };
+        struct FlatPin {
+            uint64_t id; // net id of a device pin, device id of a net pin
+            PIN_MAGIC pinMagic;
+        };
+        static constexpr uint64_t NO_NET = UINT64_MAX;
+    private:
+        std::shared_ptr<Netlist> _netlist;
+        size_t _partitionBytes;
+        MappedFile _devices, _devicePins, _netOffsets, _netPins;
+        uint64_t _deviceNum{0}, _netNum{0};
+        size_t _releasedPins{0};
+        bool _ok{true};
+        std::unordered_map<NET_NAME, uint64_t, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _globalIds;
+        std::vector<std::pair<uint64_t, NET_NAME> > _namedNets; // top ports and global nets, matched by name
+    private:
+        uint64_t GetId(uint64_t* slot);
+        void FlattenCell(const std::shared_ptr<Cell>& cell, const std::vector<uint64_t*>& portSlots);
+        void BuildNetPins();
+    public:
+        FlatGraph(const std::shared_ptr<Netlist>& netlist, const std::string& directory, size_t partitionBytes);
+        FlatGraph(const FlatGraph&) = delete;
+        FlatGraph& operator= (const FlatGraph&) = delete;
+
+        bool Build(); // false if a scratch file can't be written
+        void SetPartitionBytes(size_t partitionBytes);
+
+        uint64_t GetDeviceNum() const;
+        uint64_t GetNetNum() const;
+        const std::vector<std::pair<uint64_t, NET_NAME> >& GetNamedNets() const;
+        size_t GetScratchBytes() const;
+
+        const FlatDevice* GetDevices() const;
+        const FlatPin* GetDevicePins() const;
+        uint64_t GetPinBegin(uint64_t deviceId) const;
+        const uint64_t* GetNetOffsets() const;
+        const FlatPin* GetNetPins() const;
+
+        // visit(begin, end) for consecutive id ranges of about _partitionBytes of scratch data each
+        template <typename F>
+        void ForEachDevicePartition(F&& visit) {
+            const FlatDevice* devices = GetDevices();
+            for (uint64_t begin = 0, end = 0; begin < _deviceNum; begin = end) {
+                const uint64_t pinBegin = GetPinBegin(begin);
+                while (end < _deviceNum && (end == begin
+                        || (devices[end].pinEnd - pinBegin) * sizeof(FlatPin) + (end - begin) * sizeof(FlatDevice) < _partitionBytes)) {
+                    ++end;
+                }
+                visit(begin, end);
+                _devicePins.Release(pinBegin * sizeof(FlatPin), devices[end - 1].pinEnd * sizeof(FlatPin));
+                _devices.Release(begin * sizeof(FlatDevice), end * sizeof(FlatDevice));
+            }
+        }
+
+        template <typename F>
+        void ForEachNetPartition(F&& visit) {
+            const uint64_t* offsets = GetNetOffsets();
+            for (uint64_t begin = 0, end = 0; begin < _netNum; begin = end) {
+                while (end < _netNum && (end == begin
+                        || (offsets[end + 1] - offsets[begin]) * sizeof(FlatPin) + (end - begin) * sizeof(uint64_t) < _partitionBytes)) {
+                    ++end;
+                }
+                visit(begin, end);
+                _netPins.Release(offsets[begin] * sizeof(FlatPin), offsets[end] * sizeof(FlatPin));
+                _netOffsets.Release(begin * sizeof(uint64_t), (end + 1) * sizeof(uint64_t));
+            }
+        }
+};
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include "nway_compare.h"
+#include "../parse/library_cache.h"
+
+NWayCompare::FLAT_SIGNATURE NWayCompare::GetFlatSignature(const std::shared_ptr<Netlist>& netlist) {
+    std::unordered_map<std::shared_ptr<Cell>, FLAT_SIGNATURE> signatures;
+    std::function<const FLAT_SIGNATURE&(const std::shared_ptr<Cell>&)> Flatten = [&](const std::shared_ptr<Cell>& cell) -> const FLAT_SIGNATURE& {
+        const auto& it = signatures.find(cell);
+        if (it != signatures.end()) {
+            return it->second;
+        }
+        FLAT_SIGNATURE signature;
+        for (const auto& device : cell->GetDevices()) {
+            if (device.second->GetDeviceType() != DEVICE_TYPE_QUOTE) {
+                ++signature[device.second->GetDeviceType()];
+            }
+        }
+        for (const auto& [son, quotes] : cell->_sons) {
+            for (const auto& [type, count] : Flatten(son)) {
+                signature[type] += count * quotes.size();
+            }
+        }
+        return signatures[cell] = std::move(signature);
+    };
+    return Flatten(netlist->GetTopCell());
+}
+
+NWayCompare::FLAT_SIZES NWayCompare::GetFlatSizes(const std::shared_ptr<Netlist>& netlist) {
+    std::unordered_map<std::shared_ptr<Cell>, FLAT_SIZES> cellSizes;
+    std::function<const FLAT_SIZES&(const std::shared_ptr<Cell>&)> Flatten = [&](const std::shared_ptr<Cell>& cell) -> const FLAT_SIZES& {
+        const auto& it = cellSizes.find(cell);
+        if (it != cellSizes.end()) {
+            return it->second;
+        }
+        FLAT_SIZES sizes;
+        auto Add = [&sizes](size_t dimension, double value, uint64_t count) {
+            if (sizes.size() <= dimension) {
+                sizes.resize(dimension + 1);
+            }
+            sizes[dimension][value] += count;
+        };
+        for (const auto& device : cell->GetDevices()) {
+            if (device.second->GetDeviceType() == DEVICE_TYPE_MOSFET) {
+                const std::vector<double> values = device.second->GetSizes();
+                for (size_t i = 0; i < values.size(); ++i) {
+                    Add(i, values[i], 1);
+                }
+            }
+        }
+        for (const auto& [son, quotes] : cell->_sons) {
+            const FLAT_SIZES& sonSizes = Flatten(son);
+            for (size_t i = 0; i < sonSizes.size(); ++i) {
+                for (const auto& [value, count] : sonSizes[i]) {
+                    Add(i, value, count * quotes.size());
+                }
+            }
+        }
+        return cellSizes[cell] = std::move(sizes);
+    };
+    return Flatten(netlist->GetTopCell());
+}
+
+bool NWayCompare::SizesPair(const FLAT_SIZES& sizes1, const FLAT_SIZES& sizes2) {
+    // matched MOSFETs agree on every size within Config::tolerance, so each size alone pairs its values one to one;
+    // in one dimension some pairing within the tolerance exists exactly when the sorted one is within it
+    if (sizes1.size() != sizes2.size()) {
+        return false;
+    }
+    const double tolerance = Config::GetInstance().tolerance;
+    for (size_t i = 0; i < sizes1.size(); ++i) {
+        auto it1 = sizes1[i].begin(), it2 = sizes2[i].begin();
+        uint64_t left1 = it1 == sizes1[i].end() ? 0 : it1->second, left2 = it2 == sizes2[i].end() ? 0 : it2->second;
+        while (it1 != sizes1[i].end() && it2 != sizes2[i].end()) {
+            if (std::fabs(it1->first - it2->first) > tolerance) {
+                return false;
+            }
+            const uint64_t paired = std::min(left1, left2);
+            left1 -= paired;
+            left2 -= paired;
+            if (left1 == 0 && ++it1 != sizes1[i].end()) {
+                left1 = it1->second;
+            }
+            if (left2 == 0 && ++it2 != sizes2[i].end()) {
+                left2 = it2->second;
+            }
+        }
+        if (it1 != sizes1[i].end() || it2 != sizes2[i].end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+READ_STATE NWayCompare::Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist) {
+    const READ_STATE readState = LibraryCache::GetInstance().Load(fileName, topCellName, netlist);
+    if (readState == READ_OK) {
+        netlist->Prepare();
+        if (Config::GetInstance().freeze) {
+            netlist->Freeze();
+        }
+    }
+    return readState;
+}
+
+READ_STATE NWayCompare::LoadReference(const std::string& fileName, const CELL_NAME& topCellName) {
+    ScopedTimer timer("LoadReference", fileName);
+    const READ_STATE readState = Load(fileName, topCellName, _reference);
+    if (readState == READ_OK) {
+        _referenceSignature = GetFlatSignature(_reference);
+        _referenceSizes = GetFlatSizes(_reference);
+    }
+    return readState;
+}
+
+void NWayCompare::AddCandidate(const std::string& fileName, const CELL_NAME& topCellName) {
+    Candidate candidate;
+    candidate.file = fileName;
+    candidate.topCell = topCellName;
+    _candidates.emplace_back(candidate);
+}
+
+void NWayCompare::RunOne(size_t index) {
+    Candidate& candidate = _candidates[index];
+    std::ostringstream orderKey;
+    orderKey << "candidate " << std::setw(6) << std::setfill('0') << index; // reported in the order of the command line
+    const ScopedOrderKey scopedOrderKey(orderKey.str());
+    ScopedTimer timer("CompareCandidate", candidate.file);
+    const auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Netlist> netlist2;
+    if ((candidate.readState = Load(candidate.file, candidate.topCell, netlist2)) != READ_OK) {
+        return;
+    }
+
+    if (GetFlatSignature(netlist2) != _referenceSignature) {
+        candidate.rejectReason = "flattened device counts differ";
+    } else if (!SizesPair(_referenceSizes, GetFlatSizes(netlist2))) {
+        candidate.rejectReason = "flattened MOSFET sizes differ";
+    } else {
+        // the compare flattens cells in place, every candidate gets its own reference
+        std::shared_ptr<Netlist> netlist1 = _reference->Clone();
+        CompareNetlist cmp(netlist1, netlist2);
+        candidate.result = cmp.Compare();
+    }
+    candidate.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void NWayCompare::Run() {
+    ThreadPool& threadPool = ThreadPool::GetInstance();
+    std::vector<std::future<void> > results;
+    for (size_t i = 0; i < _candidates.size(); ++i) {
+        results.emplace_back(threadPool.Submit([this, i]() { RunOne(i); }));
+    }
+    for (std::future<void>& result : results) {
+        threadPool.Wait(result);
+    }
+}
+
+std::string NWayCompare::Report() const {
+    std::ostringstream out;
+    for (const Candidate& candidate : _candidates) {
+        out << candidate.file << " (" << candidate.topCell << "): ";
+        if (candidate.readState != READ_OK) {
+            out << "read error " << static_cast<int16_t>(candidate.readState) << std::endl;
+        } else if (candidate.rejectReason != nullptr) {
+            out << "Compare False, " << candidate.rejectReason << std::endl;
+        } else {
+            out << (candidate.result == COMPARE_NETLIST_TRUE ? "Compare True" : "Compare False")
+                << ", " << candidate.seconds << "s" << std::endl;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include "compare_netlist.h"
+#include "../base/thread_pool.h"
+
+// One reference netlist against many candidates. The reference is parsed, prepared and frozen once, then
+// every candidate is compared against a clone of it, concurrently on ThreadPool. A candidate whose flattened
+// device counts differ from the reference, or whose flattened MOSFET W or L can't be paired with those of the
+// reference within Config::tolerance, is rejected without a compare; both summaries of the reference are built once.
+// Candidates that pass still pay a clone and a full compare: the compare flattens cells in place, and its initial
+// buckets are not reusable, PropertyBins cluster the sizes of both cells of a pair, a bin built from the reference
+// alone could split sizes PropertyCompare accepts.
+class NWayCompare {
+    private:
+        typedef std::map<DEVICE_TYPE, uint64_t> FLAT_SIGNATURE; // flattened device count per type
+        typedef std::vector<std::map<double, uint64_t> > FLAT_SIZES; // flattened MOSFET count per value, one map per GetSizes entry
+        struct Candidate {
+            std::string file;
+            CELL_NAME topCell;
+            READ_STATE readState{READ_OK};
+            COMPARE_NETLIST_RESULT result{COMPARE_NETLIST_FALSE};
+            const char* rejectReason{nullptr}; // rejected without a compare
+            double seconds{0.0};
+        };
+        std::shared_ptr<Netlist> _reference;
+        FLAT_SIGNATURE _referenceSignature;
+        FLAT_SIZES _referenceSizes;
+        std::vector<Candidate> _candidates;
+    private:
+        static FLAT_SIGNATURE GetFlatSignature(const std::shared_ptr<Netlist>& netlist);
+        static FLAT_SIZES GetFlatSizes(const std::shared_ptr<Netlist>& netlist);
+        static bool SizesPair(const FLAT_SIZES& sizes1, const FLAT_SIZES& sizes2); // same count, false if some value has no partner
+        static READ_STATE Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist);
+        void RunOne(size_t index);
+    public:
+        READ_STATE LoadReference(const std::string& fileName, const CELL_NAME& topCellName);
+        void AddCandidate(const std::string& fileName, const CELL_NAME& topCellName);
+        void Run();
+        std::string Report() const;
+};
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <filesystem>
+#include <unordered_set>
+#include "out_of_core_compare.h"
+#include "property_bins.h"
+#include "../base/profile.h"
+#include "../netlist/memory_report.h"
+
+constexpr HASH_VALUE FLAT_NET_COLOR = 917981353ll;
+constexpr HASH_VALUE FLAT_NAMED_NET_COLOR = 249733301ll; // mixed with the name of a top port or global net
+constexpr HASH_VALUE FLAT_INDIVIDUAL_COLOR = 684829261ll; // mixed with the depth of an individualized device pair
+constexpr size_t MIN_PARTITION_BYTES = 4ull << 20;
+constexpr uint32_t MAX_INDIVIDUALIZATIONS = 64; // device pairs fixed before the verdict is left inconclusive
+constexpr size_t MAX_CANDIDATES = 16; // netlist2 devices tried for one individualized netlist1 device
+
+OutOfCoreCompare::OutOfCoreCompare(const std::shared_ptr<Netlist>& netlist1, const std::shared_ptr<Netlist>& netlist2):
+    _netlists{netlist1, netlist2} {}
+
+size_t OutOfCoreCompare::GetPartitionBytes(uint64_t residentBytes) const {
+    const uint64_t budget = Config::GetInstance().memoryBudgetMB << 20;
+    if (budget < residentBytes + 2 * MIN_PARTITION_BYTES) {
+        return MIN_PARTITION_BYTES;
+    }
+    return (budget - residentBytes) / 2;
+}
+
+void OutOfCoreCompare::AssignInitialColors() {
+    ScopedTimer timer("AssignInitialColors");
+    // one color per hierarchical device, the bins see the values of both netlists
+    PropertyBins bins;
+    std::unordered_map<Device*, HASH_VALUE> colors;
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        const FlatGraph::FlatDevice* devices = _graphs[id]->GetDevices();
+        _graphs[id]->ForEachDevicePartition([&](uint64_t begin, uint64_t end) {
+            for (uint64_t device = begin; device < end; ++device) {
+                Device* hierDevice = devices[device].device;
+                if (colors.emplace(hierDevice, 0).second) {
+                    bins.Add(hierDevice->GetDeviceType(), hierDevice->GetSizes());
+                }
+            }
+        });
+    }
+    bins.Build();
+    for (auto& it : colors) {
+        it.second = MixHash(it.first->GetDeviceType(), bins.GetColor(it.first->GetDeviceType(), it.first->GetSizes()));
+    }
+
+    const StringCaseInsensitiveHash nameHash;
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        const FlatGraph::FlatDevice* devices = _graphs[id]->GetDevices();
+        _deviceColors[id].resize(_graphs[id]->GetDeviceNum());
+        _graphs[id]->ForEachDevicePartition([&](uint64_t begin, uint64_t end) {
+            for (uint64_t device = begin; device < end; ++device) {
+                _deviceColors[id][device] = colors[devices[device].device];
+            }
+        });
+
+        _netColors[id].assign(_graphs[id]->GetNetNum(), FLAT_NET_COLOR);
+        _fixedNets[id].assign(_graphs[id]->GetNetNum(), false);
+        for (const auto& [net, name] : _graphs[id]->GetNamedNets()) {
+            _netColors[id][net] = MixHash(FLAT_NAMED_NET_COLOR, nameHash(name) % HASH_MOD_2);
+            _fixedNets[id][net] = true;
+        }
+    }
+}
+
+void OutOfCoreCompare::RefineDevices(NETLIST_ID id) {
+    const FlatGraph::FlatDevice* devices = _graphs[id]->GetDevices();
+    const FlatGraph::FlatPin* pins = _graphs[id]->GetDevicePins();
+    const std::vector<HASH_VALUE>& netColors = _netColors[id];
+    std::vector<HASH_VALUE>& deviceColors = _deviceColors[id];
+    _graphs[id]->ForEachDevicePartition([&](uint64_t begin, uint64_t end) {
+        for (uint64_t device = begin, pin = _graphs[id]->GetPinBegin(begin); device < end; ++device) {
+            HASH_VALUE sum = 0; // pins of the same magic are permutable
+            for (; pin < devices[device].pinEnd; ++pin) {
+                sum = (sum + MixHash(netColors[pins[pin].id], pins[pin].pinMagic)) % HASH_MOD_2;
+            }
+            deviceColors[device] = MixHash(deviceColors[device], sum);
+        }
+    });
+}
+
+void OutOfCoreCompare::RefineNets(NETLIST_ID id) {
+    const uint64_t* offsets = _graphs[id]->GetNetOffsets();
+    const FlatGraph::FlatPin* pins = _graphs[id]->GetNetPins();
+    const std::vector<HASH_VALUE>& deviceColors = _deviceColors[id];
+    std::vector<HASH_VALUE>& netColors = _netColors[id];
+    _graphs[id]->ForEachNetPartition([&](uint64_t begin, uint64_t end) {
+        for (uint64_t net = begin; net < end; ++net) {
+            if (_fixedNets[id][net]) {
+                continue;
+            }
+            HASH_VALUE sum = 0;
+            for (uint64_t pin = offsets[net]; pin < offsets[net + 1]; ++pin) {
+                sum = (sum + MixHash(deviceColors[pins[pin].id], pins[pin].pinMagic)) % HASH_MOD_2;
+            }
+            netColors[net] = MixHash(netColors[net], sum);
+        }
+    });
+}
+
+bool OutOfCoreCompare::RefineUntilStable() {
+    size_t lastClasses = 0;
+    while (true) {
+        HASH_VALUE color = 0;
+        if (!CompareClasses(_deviceColors[0], _deviceColors[1], _deviceClasses, color)) {
+            _failure = "device class differs after " + std::to_string(_iterations) + " iterations: "
+                + DescribeDevice(NETLIST_1, color) + "; " + DescribeDevice(NETLIST_2, color);
+            return false;
+        }
+        if (!CompareClasses(_netColors[0], _netColors[1], _netClasses, color)) {
+            _failure = "net class differs after " + std::to_string(_iterations) + " iterations";
+            return false;
+        }
+        if (_deviceClasses + _netClasses == lastClasses) {
+            return true; // refinement only splits classes, the same count means nothing split
+        }
+        lastClasses = _deviceClasses + _netClasses;
+
+        ScopedTimer iterationTimer("OutOfCoreIteration", std::to_string(_iterations));
+        for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+            RefineDevices(id);
+            RefineNets(id);
+        }
+        ++_iterations;
+    }
+}
+
+bool OutOfCoreCompare::FindSharedDevice(uint64_t& device) const {
+    // the smallest class leaves the fewest candidates to try
+    std::vector<HASH_VALUE> sorted(_deviceColors[0]);
+    std::sort(sorted.begin(), sorted.end());
+    HASH_VALUE color = 0;
+    size_t classSize = SIZE_MAX;
+    for (size_t i = 0, j = 0; i < sorted.size(); i = j) {
+        while (j < sorted.size() && sorted[j] == sorted[i]) {
+            ++j;
+        }
+        if (j - i > 1 && j - i < classSize) {
+            color = sorted[i];
+            classSize = j - i;
+        }
+    }
+    if (classSize == SIZE_MAX) {
+        return false;
+    }
+    device = std::find(_deviceColors[0].begin(), _deviceColors[0].end(), color) - _deviceColors[0].begin();
+    return true;
+}
+
+bool OutOfCoreCompare::CompareClasses(const std::vector<HASH_VALUE>& colors1, const std::vector<HASH_VALUE>& colors2,
+    size_t& classNum, HASH_VALUE& color)
+{
+    // one sorted copy at a time, the first one is reduced to its classes before the second is made
+    std::vector<HASH_VALUE> sorted(colors1);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::pair<HASH_VALUE, uint64_t> > classes;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (i == 0 || sorted[i] != sorted[i - 1]) {
+            classes.emplace_back(sorted[i], 0);
+        }
+        ++classes.back().second;
+    }
+    classNum = classes.size();
+    sorted.assign(colors2.begin(), colors2.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t index = 0;
+    for (size_t i = 0; i < sorted.size(); ) {
+        size_t j = i;
+        while (j < sorted.size() && sorted[j] == sorted[i]) {
+            ++j;
+        }
+        if (index < classes.size() && classes[index].first < sorted[i]) {
+            color = classes[index].first;
+            return false;
+        }
+        if (index == classes.size() || classes[index].first != sorted[i] || classes[index].second != j - i) {
+            color = sorted[i];
+            return false;
+        }
+        ++index;
+        i = j;
+    }
+    if (index < classes.size()) {
+        color = classes[index].first;
+        return false;
+    }
+    return true;
+}
+
+std::string OutOfCoreCompare::DescribeDevice(NETLIST_ID id, HASH_VALUE color) const {
+    const std::vector<HASH_VALUE>& colors = _deviceColors[id];
+    const size_t count = std::count(colors.begin(), colors.end(), color);
+    std::string description = "netlist" + std::to_string(id + 1) + " has " + std::to_string(count);
+    const auto it = std::find(colors.begin(), colors.end(), color);
+    if (it != colors.end()) {
+        const Device* device = _graphs[id]->GetDevices()[it - colors.begin()].device;
+        const std::shared_ptr<Cell> cell = device->GetCell();
+        description += ", e.g. " + device->GetName() + " in " + (cell ? cell->GetName() : std::string("?"));
+    }
+    return description;
+}
+
+COMPARE_NETLIST_RESULT OutOfCoreCompare::Compare() {
+    ScopedTimer timer("OutOfCoreCompare");
+    const Config& config = Config::GetInstance();
+    const std::string directory = config.scratchDirectory.empty() ? std::filesystem::temp_directory_path().string()
+        : config.scratchDirectory;
+
+    uint64_t resident = MemoryReport::GetCurrentRss(); // the hierarchical netlists
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        _graphs[id] = std::make_unique<FlatGraph>(_netlists[id], directory, GetPartitionBytes(resident));
+        if (!_graphs[id]->Build()) {
+            _failure = "can't write scratch files in " + directory;
+            return COMPARE_NETLIST_FALSE;
+        }
+    }
+    for (const auto& [name, num1, num2] : {
+            std::make_tuple("devices", _graphs[0]->GetDeviceNum(), _graphs[1]->GetDeviceNum()),
+            std::make_tuple("nets", _graphs[0]->GetNetNum(), _graphs[1]->GetNetNum())}) {
+        if (num1 != num2) {
+            _failure = std::string(name) + " " + std::to_string(num1) + " vs " + std::to_string(num2);
+            return COMPARE_NETLIST_FALSE;
+        }
+    }
+
+    // colors of both sides and their snapshot while a pairing is tried, plus the sorted copy and the class list of CompareClasses
+    const uint64_t elementNum = std::max(_graphs[0]->GetDeviceNum(), _graphs[0]->GetNetNum());
+    resident += (_graphs[0]->GetDeviceNum() + _graphs[0]->GetNetNum()) * 4 * sizeof(HASH_VALUE)
+        + elementNum * (sizeof(HASH_VALUE) + sizeof(std::pair<HASH_VALUE, uint64_t>));
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        _graphs[id]->SetPartitionBytes(GetPartitionBytes(resident));
+    }
+    if ((config.memoryBudgetMB << 20) < resident) {
+        OUT << "memory budget " << config.memoryBudgetMB << "MB is below the resident color arrays, "
+            << (resident >> 20) << "MB are used" << std::endl;
+    }
+
+    AssignInitialColors();
+    if (!RefineUntilStable()) {
+        return COMPARE_NETLIST_FALSE;
+    }
+
+    // once every device class is a singleton the pairing is a bijection that refinement proved, nets follow the device pins
+    uint64_t pivot = 0;
+    for (uint32_t depth = 0; FindSharedDevice(pivot); ++depth) {
+        if (depth == MAX_INDIVIDUALIZATIONS) {
+            _failure = "device classes still shared after " + std::to_string(depth) + " individualized pairs";
+            return COMPARE_NETLIST_INCONCLUSIVE;
+        }
+        const HASH_VALUE color = _deviceColors[0][pivot];
+        const HASH_VALUE individualColor = MixHash(MixHash(FLAT_INDIVIDUAL_COLOR, depth), color);
+        const std::vector<HASH_VALUE> deviceColors[2] = {_deviceColors[0], _deviceColors[1]};
+        const std::vector<HASH_VALUE> netColors[2] = {_netColors[0], _netColors[1]};
+
+        std::vector<uint64_t> candidates;
+        for (uint64_t device = 0; device < deviceColors[1].size(); ++device) {
+            if (deviceColors[1][device] == color) {
+                candidates.emplace_back(device);
+            }
+        }
+        const size_t tryNum = std::min(candidates.size(), MAX_CANDIDATES);
+        bool paired = false;
+        for (size_t i = 0; i < tryNum && !paired; ++i) {
+            ScopedTimer individualizeTimer("OutOfCoreIndividualize", std::to_string(_individualized));
+            ++_individualized;
+            _deviceColors[0][pivot] = individualColor;
+            _deviceColors[1][candidates[i]] = individualColor;
+            paired = RefineUntilStable();
+            if (!paired) {
+                for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+                    _deviceColors[id] = deviceColors[id];
+                    _netColors[id] = netColors[id];
+                }
+            }
+        }
+        if (!paired) {
+            const Device* device = _graphs[NETLIST_1]->GetDevices()[pivot].device;
+            // below a pairing already made, a refuted candidate may only mean that pairing was wrong
+            if (depth == 0 && tryNum == candidates.size()) {
+                _failure = "no device of netlist2 can take the place of " + device->GetName() + ", every candidate was refuted";
+                return COMPARE_NETLIST_FALSE;
+            }
+            _failure = "no pairing of " + device->GetName() + " found after " + std::to_string(depth) + " individualized pairs";
+            return COMPARE_NETLIST_INCONCLUSIVE;
+        }
+    }
+    _failure.clear(); // refuted candidates along the way
+    return COMPARE_NETLIST_TRUE;
+}
+
+std::string OutOfCoreCompare::Report() const {
+    std::ostringstream out;
+    for (NETLIST_ID id : {NETLIST_1, NETLIST_2}) {
+        if (_graphs[id]) {
+            out << "flat netlist" << id + 1 << ": " << _graphs[id]->GetDeviceNum() << " devices, "
+                << _graphs[id]->GetNetNum() << " nets, " << (_graphs[id]->GetScratchBytes() >> 20) << "MB scratch" << std::endl;
+        }
+    }
+    out << _iterations << " iterations, " << _individualized << " individualized, " << _deviceClasses << " device classes, " << _netClasses << " net classes, peak rss "
+        << (MemoryReport::GetPeakRss() >> 20) << "MB" << std::endl;
+    if (!_failure.empty()) {
+        out << "  " << _failure << std::endl;
+    }
+    return out.str();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "flat_graph.h"
+
+// Flat compare of two netlists within Config::memoryBudgetMB. Both designs are flattened into FlatGraph
+// scratch files and refined partition by partition; only the device and net color arrays, and a sorted
+// copy of one of them while the classes are counted, stay resident.
+// Colors follow CompareCell: initial device colors are the type and the PropertyBins of the sizes, top
+// ports and global nets are fixed by name. The netlists match when every refinement round yields the same
+// color classes with the same sizes on both sides. Refinement alone can't tell some graphs apart, e.g. one
+// ring of inverters from two shorter ones, so while a device class keeps several members one device of it
+// is individualized on each side and refined again, trying up to MAX_CANDIDATES devices of netlist2 in turn.
+// The netlists differ if every candidate of the first pairing is refuted; past MAX_INDIVIDUALIZATIONS pairs,
+// a longer class or a refuted later pairing the verdict is COMPARE_NETLIST_INCONCLUSIVE, never a match.
+class OutOfCoreCompare {
+    private:
+        std::shared_ptr<Netlist> _netlists[2];
+        std::unique_ptr<FlatGraph> _graphs[2];
+        std::vector<HASH_VALUE> _deviceColors[2], _netColors[2];
+        std::vector<bool> _fixedNets[2];
+        uint32_t _iterations{0};
+        uint32_t _individualized{0}; // device pairs fixed, including the ones taken back
+        size_t _deviceClasses{0}, _netClasses{0};
+        std::string _failure; // first difference, empty on match
+    private:
+        size_t GetPartitionBytes(uint64_t residentBytes) const; // what is left of the budget, shared by the two graphs
+        void AssignInitialColors();
+        void RefineDevices(NETLIST_ID id);
+        void RefineNets(NETLIST_ID id);
+        bool RefineUntilStable(); // false if the classes of the two sides differ on the way
+        bool FindSharedDevice(uint64_t& device) const; // a netlist1 device of the smallest class with several members
+        // false if the color multisets differ, then color is one whose counts differ
+        static bool CompareClasses(const std::vector<HASH_VALUE>& colors1, const std::vector<HASH_VALUE>& colors2,
+            size_t& classNum, HASH_VALUE& color);
+        std::string DescribeDevice(NETLIST_ID id, HASH_VALUE color) const;
+    public:
+        OutOfCoreCompare(const std::shared_ptr<Netlist>& netlist1, const std::shared_ptr<Netlist>& netlist2);
+        COMPARE_NETLIST_RESULT Compare();
+        std::string Report() const;
+};
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "process_compare.h"
+#include "../base/profile.h"
+
+constexpr uint32_t MAX_WORKER_ATTEMPTS = 2;
+constexpr uint32_t JOBS_PER_PROCESS = 4; // smaller subtrees balance better, each one costs a fork
+
+ProcessCompare::ProcessCompare(const std::shared_ptr<Netlist>& netlist1, const std::shared_ptr<Netlist>& netlist2,
+    CompareNetlist& compareNetlist): _netlist1(netlist1), _netlist2(netlist2), _compareNetlist(compareNetlist) {}
+
+void ProcessCompare::Partition() {
+    std::unordered_map<std::shared_ptr<Cell>, uint64_t> weights;
+    std::function<uint64_t(const std::shared_ptr<Cell>&)> GetWeight = [&](const std::shared_ptr<Cell>& cell) -> uint64_t {
+        const auto& it = weights.find(cell);
+        if (it != weights.end()) {
+            return it->second;
+        }
+        uint64_t weight = 0;
+        for (const auto& device : cell->GetDevices()) {
+            weight += device.second->GetDeviceType() != DEVICE_TYPE_QUOTE;
+        }
+        for (const auto& [son, quotes] : cell->_sons) {
+            weight += GetWeight(son) * quotes.size();
+        }
+        return weights[cell] = weight;
+    };
+
+    const std::shared_ptr<Cell> topCell = _netlist1->GetTopCell();
+    const uint64_t target = std::max<uint64_t>(1, GetWeight(topCell) / (Config::GetInstance().processNum * JOBS_PER_PROCESS));
+    std::unordered_set<std::shared_ptr<Cell> > visited;
+    std::function<void(const std::shared_ptr<Cell>&)> Visit = [&](const std::shared_ptr<Cell>& cell) {
+        if (!visited.insert(cell).second) {
+            return;
+        }
+        const std::shared_ptr<Cell> cell2 = _netlist2->FindCell(cell->GetName());
+        if (cell2 != nullptr && (GetWeight(cell) <= target || cell->_sons.empty())) {
+            _jobs.push_back({cell->GetName(), cell2->GetName(), GetWeight(cell), 0, ""});
+            return;
+        }
+        for (const auto& son : cell->_sons) {
+            Visit(son.first);
+        }
+    };
+    for (const auto& son : topCell->_sons) {
+        Visit(son.first);
+    }
+
+    // heavy subtrees first, so the last worker to finish is a light one
+    std::sort(_jobs.begin(), _jobs.end(), [](const Job& job1, const Job& job2) { return job1.weight > job2.weight; });
+    for (size_t i = 0; i < _jobs.size(); ++i) {
+        _pendingJobs.emplace_back(i);
+    }
+}
+
+std::string ProcessCompare::Serialize(const std::vector<CompareNetlist::ExternalResult>& results) {
+    // one line per cell pair: name1 name2 result n1 pinMagics1... n2 pinMagics2...
+    std::ostringstream out;
+    for (const CompareNetlist::ExternalResult& result : results) {
+        out << result.cellName1 << " " << result.cellName2 << " " << static_cast<int32_t>(result.result);
+        for (const std::vector<PIN_MAGIC>* pinMagics : {&result.portPinMagics1, &result.portPinMagics2}) {
+            out << " " << pinMagics->size();
+            for (PIN_MAGIC pinMagic : *pinMagics) {
+                out << " " << pinMagic;
+            }
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+bool ProcessCompare::Deserialize(const std::string& message, std::vector<CompareNetlist::ExternalResult>& results) {
+    std::istringstream in(message);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        CompareNetlist::ExternalResult result;
+        int32_t verdict;
+        if (!(fields >> result.cellName1 >> result.cellName2 >> verdict)) {
+            return false;
+        }
+        result.result = static_cast<COMPARE_CELL_RESULT>(verdict);
+        for (std::vector<PIN_MAGIC>* pinMagics : {&result.portPinMagics1, &result.portPinMagics2}) {
+            size_t size;
+            if (!(fields >> size)) {
+                return false;
+            }
+            pinMagics->resize(size);
+            for (PIN_MAGIC& pinMagic : *pinMagics) {
+                if (!(fields >> pinMagic)) {
+                    return false;
+                }
+            }
+        }
+        results.emplace_back(std::move(result));
+    }
+    return true;
+}
+
+void ProcessCompare::WorkerMain(const Job& job, int fd) {
+    // only this thread survives the fork: no pool, and no profiler whose lock another thread may hold
+    Config::GetInstance().multiThread = false;
+    Profile::GetInstance().SetEnabled(false);
+
+    if (_netlist1->SetTopCell(job.cellName1) != READ_OK || _netlist2->SetTopCell(job.cellName2) != READ_OK) {
+        _exit(EXIT_FAILURE);
+    }
+    CompareNetlist compareNetlist(_netlist1, _netlist2);
+    compareNetlist.SetTopQuoted(); // parents in the coordinator read the pin magics of the job cells
+    compareNetlist.Compare();
+
+    // the coordinator knows the reply is complete from the size in front of it
+    const std::string payload = Serialize(compareNetlist.ExportResults());
+    const uint64_t size = payload.size();
+    std::string message(reinterpret_cast<const char*>(&size), sizeof(size));
+    message += payload;
+    for (size_t written = 0; written < message.size(); ) {
+        const ssize_t count = send(fd, message.data() + written, message.size() - written, MSG_NOSIGNAL);
+        if (count < 0 && errno != EINTR) {
+            _exit(EXIT_FAILURE);
+        }
+        written += std::max<ssize_t>(count, 0);
+    }
+    _exit(EXIT_SUCCESS); // no destructors, the parent owns everything this process saw
+}
+
+bool ProcessCompare::Spawn(size_t job, Worker& worker) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        WorkerMain(_jobs[job], fds[1]);
+    }
+    close(fds[1]);
+    worker.pid = pid;
+    worker.fd = fds[0];
+    worker.job = job;
+    worker.reply.clear();
+    worker.timedOut = false;
+    worker.start = std::chrono::steady_clock::now();
+    ++_jobs[job].attempts;
+    return true;
+}
+
+void ProcessCompare::Finish(Worker& worker) {
+    close(worker.fd);
+    int status = 0;
+    waitpid(worker.pid, &status, 0);
+    Job& job = _jobs[worker.job];
+    worker.pid = -1;
+    worker.fd = -1;
+
+    uint64_t size = 0;
+    if (worker.reply.size() >= sizeof(size)) {
+        std::memcpy(&size, worker.reply.data(), sizeof(size));
+    }
+    std::vector<CompareNetlist::ExternalResult> results;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS && worker.reply.size() == sizeof(size) + size
+            && Deserialize(worker.reply.substr(sizeof(size)), results)) {
+        for (const CompareNetlist::ExternalResult& result : results) {
+            _compareNetlist.AddExternalResult(result);
+        }
+        return;
+    }
+
+    if (!worker.timedOut && job.attempts < MAX_WORKER_ATTEMPTS) {
+        ++_restarts;
+        _pendingJobs.emplace_front(worker.job);
+        return;
+    }
+    job.failure = worker.timedOut ? "timeout" : WIFSIGNALED(status) ? "signal " + std::to_string(WTERMSIG(status))
+        : "exit " + std::to_string(WEXITSTATUS(status));
+    _compareNetlist.AddExternalResult({job.cellName1, job.cellName2, COMPARE_CELL_FALSE, {}, {}});
+}
+
+void ProcessCompare::Run() {
+    ScopedTimer timer("ProcessCompare");
+    const Config& config = Config::GetInstance();
+    Partition();
+
+    std::vector<Worker> workers(std::min<size_t>(config.processNum, _jobs.size()));
+    while (true) {
+        for (Worker& worker : workers) {
+            while (worker.pid < 0 && !_pendingJobs.empty()) {
+                const size_t job = _pendingJobs.front();
+                _pendingJobs.pop_front();
+                if (!Spawn(job, worker)) {
+                    _jobs[job].failure = "fork failed";
+                    _compareNetlist.AddExternalResult({_jobs[job].cellName1, _jobs[job].cellName2, COMPARE_CELL_FALSE, {}, {}});
+                }
+            }
+        }
+
+        std::vector<pollfd> pollFds;
+        std::vector<Worker*> polled;
+        for (Worker& worker : workers) {
+            if (worker.pid >= 0) {
+                pollFds.push_back({worker.fd, POLLIN, 0});
+                polled.emplace_back(&worker);
+            }
+        }
+        if (pollFds.empty()) {
+            break;
+        }
+        poll(pollFds.data(), pollFds.size(), 100);
+
+        for (size_t i = 0; i < polled.size(); ++i) {
+            Worker& worker = *polled[i];
+            if (pollFds[i].revents != 0) {
+                char buffer[1 << 16];
+                const ssize_t count = read(worker.fd, buffer, sizeof(buffer));
+                if (count > 0) {
+                    worker.reply.append(buffer, count);
+                } else if (count == 0 || errno != EINTR) {
+                    Finish(worker);
+                }
+                continue;
+            }
+            if (config.processTimeout > 0
+                    && std::chrono::steady_clock::now() - worker.start > std::chrono::seconds(config.processTimeout)) {
+                worker.timedOut = true;
+                kill(worker.pid, SIGKILL);
+                Finish(worker);
+            }
+        }
+    }
+}
+
+std::string ProcessCompare::Report() const {
+    std::ostringstream out;
+    size_t failed = 0;
+    for (const Job& job : _jobs) {
+        failed += !job.failure.empty();
+    }
+    out << _jobs.size() << " subtrees in worker processes, " << _restarts << " restarts, " << failed << " failed" << std::endl;
+    for (const Job& job : _jobs) {
+        if (!job.failure.empty()) {
+            out << "  " << job.cellName1 << " vs " << job.cellName2 << ": " << job.failure << std::endl;
+        }
+    }
+    return out.str();
+}
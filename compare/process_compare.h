@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <sys/types.h>
+#include "compare_netlist.h"
+
+// Hierarchical compare spread over worker processes on this host. The cell DAG is cut into subtrees of
+// bounded flattened size, paired by name across the netlists. Every subtree runs in a forked worker, so
+// the fork is a copy-on-write snapshot of both parsed netlists and nothing is serialized on the way in;
+// the worker sends its verdicts and port labels back over a socketpair. They go into the coordinator's
+// CompareNetlist, which then only compares the cells above the subtrees.
+// A worker that dies is retried in a fresh process. A subtree that fails every attempt or runs past
+// Config::processTimeout is reported as a mismatch instead of taking the coordinator down.
+class ProcessCompare {
+    private:
+        struct Job {
+            CELL_NAME cellName1, cellName2;
+            uint64_t weight; // flattened devices in netlist1
+            uint32_t attempts{0};
+            std::string failure; // empty unless the subtree never got a verdict
+        };
+        struct Worker {
+            pid_t pid{-1};
+            int fd{-1};
+            size_t job;
+            std::string reply;
+            bool timedOut{false};
+            std::chrono::steady_clock::time_point start;
+        };
+        std::shared_ptr<Netlist> _netlist1, _netlist2;
+        CompareNetlist& _compareNetlist;
+        std::vector<Job> _jobs;
+        std::deque<size_t> _pendingJobs;
+        uint32_t _restarts{0};
+    private:
+        void Partition();
+        bool Spawn(size_t job, Worker& worker);
+        [[noreturn]] void WorkerMain(const Job& job, int fd);
+        void Finish(Worker& worker);
+        static std::string Serialize(const std::vector<CompareNetlist::ExternalResult>& results);
+        static bool Deserialize(const std::string& message, std::vector<CompareNetlist::ExternalResult>& results);
+    public:
+        ProcessCompare(const std::shared_ptr<Netlist>& netlist1, const std::shared_ptr<Netlist>& netlist2, CompareNetlist& compareNetlist);
+        void Run(); // before CompareNetlist::Compare
+        std::string Report() const;
+};
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include "property_bins.h"
+
+void PropertyBins::Add(DEVICE_TYPE type, const std::vector<double>& sizes) {
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        _values[{type, i}].emplace_back(sizes[i]);
+    }
+    _built = false;
+}
+
+void PropertyBins::Build() {
+    const double tolerance = Config::GetInstance().tolerance;
+
+    for (auto& it : _values) {
+        std::vector<double>& values = it.second;
+        std::sort(values.begin(), values.end());
+
+        // keep the first value of every chain of close values
+        std::vector<double> lowerBounds;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i == 0 || values[i] - values[i - 1] > tolerance) {
+                lowerBounds.emplace_back(values[i]);
+            }
+        }
+        values.swap(lowerBounds);
+        values.shrink_to_fit();
+    }
+    _built = true;
+}
+
+HASH_VALUE PropertyBins::GetColor(DEVICE_TYPE type, const std::vector<double>& sizes) const {
+    HASH_VALUE color = 0;
+    if (!_built) {
+        return color;
+    }
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const auto it = _values.find({type, i});
+        if (it == _values.end()) {
+            continue;
+        }
+        const std::vector<double>& lowerBounds = it->second;
+        const size_t bin = std::upper_bound(lowerBounds.begin(), lowerBounds.end(), sizes[i]) - lowerBounds.begin();
+        color = MixHash(color, bin + 1);
+    }
+    return color;
+}
+
+void PropertyBins::Clear() {
+    _values.clear();
+    _built = false;
+}
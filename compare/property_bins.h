@@ -0,0 +1,21 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include "../base/base.h"
+
+// Tolerance-aware quantization of numeric device properties.
+// Values of both netlists are clustered together: sorted values whose gap is no larger than
+// Config::tolerance fall into one bin, so two values that PropertyCompare accepts never get
+// different bins.
+class PropertyBins {
+    private:
+        typedef std::pair<DEVICE_TYPE, size_t> BIN_KEY; // device type, property dimension
+        std::map<BIN_KEY, std::vector<double> > _values; // collected values, then lower bound of every bin
+        bool _built{false};
+    public:
+        void Add(DEVICE_TYPE type, const std::vector<double>& sizes);
+        void Build();
+        HASH_VALUE GetColor(DEVICE_TYPE type, const std::vector<double>& sizes) const;
+        void Clear();
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <fstream>
+#include <vector>
+#include <map>
+#include "trace.h"
 
 class Config {
 public:
@@ -9,27 +12,42 @@ public:
     std::string file2 = "layout2.sp";
     std::string topCell2 = "SOP_DC_X128Y8_620"; // if can't find cell name， use main cell default
     std::string outputFileName = "";
+    std::string scopePath1 = ""; // instance path below topCell1, e.g. "X1/X3", empty compares the whole top cell
+    std::string scopePath2 = "";
 
     bool caseInsensitive = false;
     bool hier = 1;
     bool autoMatch = false; // Temporarily unavailable
     bool multiThread = 1;
+    uint32_t processNum = 0; // hier only: worker processes for independent subtrees, 0 compares in this process
+    uint32_t processTimeout = 0; // seconds a subtree worker may run before it is killed, 0 waits
     double tolerance = 1e-6;
+    bool failFast = false; // stop at the first cell mismatch, otherwise only doomed ancestors are skipped
+    bool diagnose = true; // report suspect devices and nets of every mismatched cell from its final buckets
+    bool propertyColoring = true; // fold binned W/L into the initial device colors
+    uint32_t hubNetDegree = 512; // nets connecting at least this many devices are hub nets, 0 disables
+    std::vector<std::string> globalNets; // always hub nets, in addition to ".GLOBAL"; "globalNets VDD,VSS" option
+    bool anchorByName = false; // pre-match nets and devices with the same name
+    bool placementColoring = false; // read $X/$Y/$T and break automorphisms by placement before forcing
+    double placementTolerance = 1e-3; // relative positions closer than this match, in the units of the annotations
+    uint64_t memoryBudgetMB = 0; // hier off only: flatten to scratch files and compare within this RAM, 0 flattens in memory
+    std::string scratchDirectory = ""; // flattened graphs of the memory budgeted compare, empty is the system temp directory
+    // subckt or device model name -> groups of swappable pins: port names of a subckt, 1-based pin positions
+    // of a model, e.g. {"NAND2", {{"A", "B"}}}, {"ncap", {{"1", "3", "4"}}}; see AddPinSwapGroups
+    std::map<std::string, std::vector<std::vector<std::string> > > pinSwapGroups;
 
-    static Config& GetInstance() {
-        static Config instance;
-        return instance;
-    }
-};
+    bool profile = false; // scoped timers and per cell counters
+    std::string traceFileName = "lvs_trace.json"; // chrome://tracing
+    std::string cellProfileFileName = "lvs_cells.csv";
+    bool memoryReport = false; // bytes per netlist structure and rss per phase
+    bool freeze = true; // Netlist::Freeze between load and compare
 
-class Debug {
-public:
-    bool executeWLShow = 1;
-    bool iterateShow = 1;
-    bool cellShow = 0;
+    bool gateLevel = false; // recognize CMOS gates and compare them as composite devices
+    std::vector<std::string> nmosModels = {"n", "dnn"}; // model name prefix
+    std::vector<std::string> pmosModels = {"p", "dnp"}; // model name prefix
 
-    static Debug& GetInstance() {
-        static Debug instance;
+    static Config& GetInstance() {
+        static Config instance;
         return instance;
     }
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// Debug output is compiled in only up to LVS_TRACE_LEVEL (the LVS_TRACE_LEVEL cmake cache variable).
+// There are no runtime switches: a release build discards every LVS_TRACE body, so hot loops pay
+// neither the branch nor the string building, and a trace build prints every compiled level.
+typedef uint8_t TRACE_LEVEL;
+constexpr TRACE_LEVEL TRACE_OFF = 0;
+constexpr TRACE_LEVEL TRACE_CELL = 1; // verdict of every cell pair
+constexpr TRACE_LEVEL TRACE_WL = 2; // result of every WL run
+constexpr TRACE_LEVEL TRACE_ITERATE = 3; // bucket counts of every iterate, unbalanced buckets
+
+#ifndef LVS_TRACE_LEVEL
+#define LVS_TRACE_LEVEL 0
+#endif
+constexpr TRACE_LEVEL COMPILED_TRACE_LEVEL = LVS_TRACE_LEVEL;
+
+template <TRACE_LEVEL level>
+constexpr bool TraceCompiled() {
+    return level != TRACE_OFF && level <= COMPILED_TRACE_LEVEL;
+}
+
+// LVS_TRACE(TRACE_ITERATE, OUT << "iterate " << i << std::endl);
+#define LVS_TRACE(level, ...) \
+    do { \
+        if constexpr (TraceCompiled<level>()) { \
+            __VA_ARGS__; \
+        } \
+    } while (0)
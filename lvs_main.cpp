@@ -2,21 +2,44 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <stdexcept>
 
-#include "compare/compare_netlist.h"
+#include "compare/batch_compare.h"
+#include "compare/nway_compare.h"
+#include "compare/out_of_core_compare.h"
+#include "compare/process_compare.h"
+#include "compare/compare_service.h"
+#include "parse/library_cache.h"
+#include "base/profile.h"
+#include "netlist/memory_report.h"
 
-READ_STATE ReadOneFile(std::shared_ptr<Netlist>& netlist, const std::string& fileRoute, const std::string& topCellName)
+READ_STATE ReadOneFile(std::shared_ptr<Netlist>& netlist, const std::string& fileRoute, const std::string& topCellName,
+    const std::string& scopePath)
 {
-    Config& config = Config::GetInstance();
-    std::unique_ptr<Spice> spice = std::make_unique<Spice>();
-    READ_STATE readState = spice->OpenReadAndParseSpice(fileRoute, topCellName);
+    ScopedTimer timer("ReadOneFile", fileRoute);
+    READ_STATE readState = LibraryCache::GetInstance().Load(fileRoute, topCellName, netlist); // follows .INCLUDE/.LIB
+    if (readState == READ_OK && !scopePath.empty()) {
+        readState = netlist->ScopeToInstancePath(scopePath);
+    }
+    if (readState == READ_OK && Config::GetInstance().placementColoring) {
+        const std::shared_ptr<Layout> layout = std::make_shared<Layout>();
+        if (layout->Read(fileRoute)) {
+            netlist->SetLayout(layout);
+        }
+    }
 
     switch (readState) {
         case NO_FILE:
             std::cout << "Error, can't open file \"" << fileRoute << "\"" << std::endl;
             break;
+        case INPUT_CORRUPT:
+            std::cout << "Error, can't read file \"" << fileRoute << "\" to its end, the compressed input is cut off or damaged" << std::endl;
+            break;
         case READ_OK:
-            netlist = spice->GetNetlist();
+            netlist->Prepare();
+            if (Config::GetInstance().freeze) {
+                MemoryReport::GetInstance().Add("Reclaimed by freeze", 1, netlist->Freeze());
+            }
             // debug
             // std::cout << "==========netlist show==========" << std::endl;
             // netlist->Show();
@@ -47,41 +70,215 @@ READ_STATE ReadTwoFiles(std::shared_ptr<Netlist>& netlist1, std::shared_ptr<Netl
     const Config& config = Config::GetInstance();
     READ_STATE readState;
 
-    if ((readState = ReadOneFile(netlist1, config.file1, config.topCell1)) != READ_OK) {
+    if ((readState = ReadOneFile(netlist1, config.file1, config.topCell1, config.scopePath1)) != READ_OK) {
         return readState;
     }
 
-    return ReadOneFile(netlist2, config.file2, config.topCell2);
+    return ReadOneFile(netlist2, config.file2, config.topCell2, config.scopePath2);
+}
+
+// lvs --batch 1 3 4 5: compare several testCase entries with shared parses
+int RunBatch(int argc, char* argv[])
+{
+    constexpr size_t caseNum = sizeof(testCase) / sizeof(testCase[0]);
+    std::vector<size_t> caseIndexes;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.empty() || arg.size() > 9 || arg.find_first_not_of("0123456789") != std::string::npos || std::stoul(arg) >= caseNum) {
+            std::cout << "Error, \"" << arg << "\" is not a testCase index, usage: lvs --batch <0-" << caseNum - 1 << "> ..." << std::endl;
+            return 1;
+        }
+        caseIndexes.emplace_back(std::stoul(arg));
+    }
+
+    BatchCompare batch;
+    for (size_t index : caseIndexes) {
+        batch.AddCase(testCase[index]);
+    }
+    SettingConfig(testCase[caseIndexes.front()]); // options of the first case apply to all, moves the file names
+    batch.Run();
+    OutputToFileOrTerminal();
+    std::cout << batch.Report();
+    return 0;
+}
+
+// lvs --nway ref.sp TOP layout1.sp layout2.sp ...: candidates use the same top cell name
+int RunNWay(int argc, char* argv[])
+{
+    NWayCompare nway;
+    if (nway.LoadReference(argv[2], argv[3]) != READ_OK) {
+        std::cout << "Error, can't load reference \"" << argv[2] << "\"" << std::endl;
+        return 1;
+    }
+    for (int i = 4; i < argc; ++i) {
+        nway.AddCandidate(argv[i], argv[3]);
+    }
+    nway.Run();
+    OutputToFileOrTerminal();
+    std::cout << nway.Report();
+    return 0;
+}
+
+// lvs --serve /tmp/lvs.sock: keep both netlists warm and compare on request, see CompareService
+int RunServe(char* argv[])
+{
+    SettingConfig(testCase[2]); // defaults of requests that don't name files or top cells
+    Profile::GetInstance().SetEnabled(Config::GetInstance().profile);
+    CompareService service(argv[2]);
+    if (!service.Start()) {
+        std::cout << "Error, can't listen on \"" << argv[2] << "\"" << std::endl;
+        return 1;
+    }
+    service.Serve();
+    return 0;
 }
 
-int main()
+// lvs --request /tmp/lvs.sock file2 layout.sp top2 TOP ...: key value pairs of one request
+int RunRequest(int argc, char* argv[])
+{
+    std::string request, reply;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        request += std::string(argv[i]) + " " + argv[i + 1] + "\n";
+    }
+    if (!CompareService::Request(argv[2], request, reply)) {
+        std::cout << "Error, can't reach \"" << argv[2] << "\"" << std::endl;
+        return 1;
+    }
+    std::cout << reply;
+    return reply.rfind("result true", 0) == 0 ? 0 : 1;
+}
+
+// lvs --compare a.sp TOP b.sp TOP gateLevel 1 tolerance 1e-8 pinSwap AND2:A,B: two files from the command line, then key value options
+bool SettingCommandLineConfig(int argc, char* argv[])
 {
-    SettingConfig(testCase[2]);
     Config& config = Config::GetInstance();
+    config.file1 = argv[2];
+    config.topCell1 = argv[3];
+    config.file2 = argv[4];
+    config.topCell2 = argv[5];
+    for (int i = 6; i < argc; i += 2) {
+        const std::string key = argv[i];
+        try {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(key);
+            } else if (key == "gateLevel") {
+                config.gateLevel = std::stoi(argv[i + 1]) != 0;
+            } else if (key == "tolerance") {
+                config.tolerance = std::stod(argv[i + 1]);
+            } else if (key == "anchorByName") {
+                config.anchorByName = std::stoi(argv[i + 1]) != 0;
+            } else if (key == "hier") {
+                config.hier = std::stoi(argv[i + 1]) != 0;
+            } else if (key == "multiThread") {
+                config.multiThread = std::stoi(argv[i + 1]) != 0;
+            } else if (key == "memoryBudgetMB") {
+                config.memoryBudgetMB = std::stoull(argv[i + 1]);
+            } else if (key == "globalNets") {
+                config.globalNets = SplitString(argv[i + 1], ',');
+            } else if (key == "pinSwap") {
+                if (!AddPinSwapGroups(argv[i + 1])) {
+                    throw std::invalid_argument(key);
+                }
+            } else {
+                throw std::invalid_argument(key);
+            }
+        } catch (const std::exception&) {
+            std::cout << "Error, bad option \"" << key << "\", usage: lvs --compare <file1> <top1> <file2> <top2> [gateLevel|tolerance|anchorByName|hier|multiThread|memoryBudgetMB <value>] [globalNets <net>,<net>...] [pinSwap <cell or model>:<pin>,<pin>...] ..." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 2 && std::string(argv[1]) == "--batch") {
+        return RunBatch(argc, argv);
+    }
+    if (argc > 4 && std::string(argv[1]) == "--nway") {
+        return RunNWay(argc, argv);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        return RunServe(argv);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--request") {
+        return RunRequest(argc, argv);
+    }
+
+    if (argc > 5 && std::string(argv[1]) == "--compare") {
+        if (!SettingCommandLineConfig(argc, argv)) {
+            return 1;
+        }
+    } else {
+        SettingConfig(testCase[2]);
+    }
+    Config& config = Config::GetInstance();
+    Profile::GetInstance().SetEnabled(config.profile);
 
     auto start_clock = std::chrono::high_resolution_clock::now();
 
     std::shared_ptr<Netlist> netlist1 = nullptr, netlist2 = nullptr;
 
     if (ReadTwoFiles(netlist1, netlist2) != READ_OK) {
-        // OutputToFileOrTerminal();
+        OutputToFileOrTerminal();
         return 0;
     }
+    if (config.memoryReport) {
+        MemoryReport& memoryReport = MemoryReport::GetInstance();
+        memoryReport.MarkPhase("parse");
+        memoryReport.AccountNetlist(netlist1);
+        memoryReport.AccountNetlist(netlist2);
+    }
 
-    CompareNetlist cmp(netlist1, netlist2);
-    COMPARE_NETLIST_RESULT result = cmp.Compare();
+    COMPARE_NETLIST_RESULT result;
+    std::vector<std::pair<CELL_NAME, CELL_NAME> > mismatchedCells;
+    std::vector<std::string> diagnoses;
+    if (!config.hier && config.memoryBudgetMB > 0) {
+        ScopedTimer timer("Compare");
+        OutOfCoreCompare cmp(netlist1, netlist2);
+        result = cmp.Compare();
+        std::cout << cmp.Report();
+    } else {
+        ScopedTimer timer("Compare");
+        CompareNetlist cmp(netlist1, netlist2);
+        if (config.hier && config.processNum > 0) {
+            ProcessCompare processCompare(netlist1, netlist2, cmp);
+            processCompare.Run();
+            std::cout << processCompare.Report();
+        }
+        result = cmp.Compare();
+        mismatchedCells = cmp.GetMismatchedCells();
+        for (const auto& mismatch : mismatchedCells) {
+            diagnoses.emplace_back(cmp.GetDiagnosis(mismatch.first, mismatch.second));
+        }
+    }
 
     // debug
     if (result == COMPARE_NETLIST_TRUE) {
         std::cout << "Compare True" << std::endl;
     } else if (result == COMPARE_NETLIST_FALSE) {
         std::cout << "Compare False" << std::endl;
+        for (size_t i = 0; i < mismatchedCells.size(); ++i) {
+            std::cout << "  mismatch " << mismatchedCells[i].first << " vs " << mismatchedCells[i].second << std::endl;
+            std::cout << diagnoses[i];
+        }
+    } else if (result == COMPARE_NETLIST_INCONCLUSIVE) {
+        std::cout << "Compare Inconclusive" << std::endl;
     }
 
-    // OutputToFileOrTerminal();
+    OutputToFileOrTerminal();
     auto end_clock = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_clock - start_clock);
     std::cout << "Run time " << duration.count() * 0.000001 << "s." << std::endl;
 
+    if (config.memoryReport) {
+        MemoryReport::GetInstance().MarkPhase("compare");
+        std::cout << MemoryReport::GetInstance().ToString();
+    }
+    if (config.profile) {
+        Profile::GetInstance().ExportChromeTrace(config.traceFileName);
+        Profile::GetInstance().ExportCellCsv(config.cellProfileFileName);
+    }
+
     return 0;
 }
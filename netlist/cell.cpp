@@ -88,10 +88,121 @@ std::shared_ptr<Net> Cell::DefineNet(const NET_NAME& netName) {
     return net;
 }
 
+uint64_t Cell::GetParameterHash() const {
+    return _parameterHash;
+}
+
+void Cell::SetParameterHash(uint64_t hash) {
+    _parameterHash = hash;
+}
+
+CELL_NAME Cell::GetBaseName() const {
+    return _baseName.empty() ? _name : _baseName;
+}
+
+void Cell::SetBaseName(const CELL_NAME& name) {
+    _baseName = name;
+}
+
+void Cell::Freeze() {
+    decltype(_portsMap)().swap(_portsMap); // ports are bound, flattened net names never hit a port name
+    _ports.shrink_to_fit();
+    _portGroups.shrink_to_fit();
+    _parents.shrink_to_fit();
+    for (auto& it : _sons) {
+        it.second.shrink_to_fit();
+    }
+    for (const auto& it : _devices) {
+        it.second->Compact();
+    }
+    _devices.rehash(0);
+    _nets.rehash(0);
+    _sons.rehash(0);
+}
+
+std::shared_ptr<Cell> Cell::Copy(const CELL_NAME& name) const {
+    const std::shared_ptr<Cell> cell = std::make_shared<Cell>(name);
+    cell->_netlist = _netlist;
+    cell->_parameters = _parameters;
+    cell->_parameterHash = _parameterHash;
+    cell->_baseName = _baseName;
+    cell->_portGroups = _portGroups;
+    cell->_portsMap = _portsMap;
+    for (const std::shared_ptr<Port>& port : _ports) {
+        cell->_ports.emplace_back(std::make_shared<Port>(port->GetName()));
+    }
+
+    // _portsMap may be abandoned, so ports are bound by index instead of DefineNet
+    std::unordered_map<std::shared_ptr<Net>, std::shared_ptr<Net> > netCopies;
+    for (const auto& it : _nets) {
+        const std::shared_ptr<Net> net = std::make_shared<Net>(it.second->GetName());
+        net->SetCell(cell);
+        net->SetNetlist(_netlist.lock());
+        const PORT_INDEX portIndex = it.second->GetPortIndex();
+        if (portIndex != NOT_PORT) {
+            net->SetPortIndex(portIndex);
+            cell->_ports[portIndex]->SetNet(net);
+        }
+        cell->_nets[it.first] = net;
+        netCopies[it.second] = net;
+    }
+
+    for (const auto& it : _devices) {
+        const std::shared_ptr<Device> device = it.second->CopyDevice(cell, it.second->GetName());
+        for (const auto& connect : it.second->GetConnectNets()) {
+            device->AddConnectNet(netCopies[connect.first], connect.second);
+        }
+        cell->_devices[it.first] = device;
+
+        const std::shared_ptr<Quote> quote = std::dynamic_pointer_cast<Quote>(it.second);
+        if (quote != nullptr) {
+            const std::shared_ptr<Quote> quoteCopy = std::dynamic_pointer_cast<Quote>(device);
+            for (const std::shared_ptr<Net>& net : quote->_pendingNets) {
+                quoteCopy->_pendingNets.emplace_back(netCopies[net]);
+            }
+            quoteCopy->_tokens = quote->_tokens;
+            cell->_quotes.emplace_front(quoteCopy);
+        }
+    }
+    return cell;
+}
+
 void Cell::SetParameterValue(const PARAMETER_NAME& parameterName, const std::string& str) {
     _parameters[parameterName] = str;
 }
 
+void Cell::SetPortPinMagics(const std::vector<PIN_MAGIC>& pinMagics) {
+    _portPinMagics = pinMagics;
+}
+
+PIN_MAGIC Cell::GetPortPinMagic(PORT_INDEX index) const {
+    if (index >= 0 && static_cast<size_t>(index) < _portPinMagics.size()) {
+        return _portPinMagics[index];
+    }
+    // before compare only declared groups are known
+    const int32_t group = GetPortGroup(index);
+    return group < 0 ? PIN_MAGIC_NO_DEFINE : MixHash(PIN_MAGIC_DECLARED_GROUP, group);
+}
+
+bool Cell::IsPortSymmetric(PORT_INDEX index1, PORT_INDEX index2) const {
+    const PIN_MAGIC pinMagic = GetPortPinMagic(index1);
+    return pinMagic != PIN_MAGIC_NO_DEFINE && pinMagic == GetPortPinMagic(index2);
+}
+
+void Cell::SetPortGroup(PORT_INDEX index, int32_t group) {
+    if (_portGroups.size() < _ports.size()) {
+        _portGroups.resize(_ports.size(), -1);
+    }
+    _portGroups[index] = group;
+}
+
+int32_t Cell::GetPortGroup(PORT_INDEX index) const {
+    if (index < 0 || static_cast<size_t>(index) >= _portGroups.size()) {
+        return -1;
+    }
+    return _portGroups[index];
+}
+
 // // 共享指针版本的 CellElement，暂时注释
 // std::shared_ptr<CompareNetlist::CellElement> Cell::GetCellElement() const {
 //     return _cellElement.lock();
@@ -22,6 +22,11 @@ class Cell: public std::enable_shared_from_this<Cell> {
         std::unordered_map<NET_NAME, std::shared_ptr<Net>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _nets;
         std::unordered_map<PARAMETER_NAME, PARAMETER_VALUE, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _parameters;
 
+        std::vector<PIN_MAGIC> _portPinMagics; // pin magic of every port seen from a quote, symmetric ports share one
+        std::vector<int32_t> _portGroups; // declared swappable group of every port, -1 if none
+        uint64_t _parameterHash{0}; // hash of the resolved parameters of a specialization, 0 for parsed cells
+        CELL_NAME _baseName; // the parsed cell a specialization was copied from, empty for parsed cells
+
         // weak_ptr<CompareNetlist::CellElement> _cellElement;
     public:
         uint32_t _inDegree, _outDegree;
@@ -56,5 +61,20 @@ class Cell: public std::enable_shared_from_this<Cell> {
 
         void SetParameterValue(const PARAMETER_NAME& parameterName, const std::string& str);
 
+        void SetPortPinMagics(const std::vector<PIN_MAGIC>& pinMagics);
+        PIN_MAGIC GetPortPinMagic(PORT_INDEX index) const; // PIN_MAGIC_NO_DEFINE before compare
+        bool IsPortSymmetric(PORT_INDEX index1, PORT_INDEX index2) const;
+        void SetPortGroup(PORT_INDEX index, int32_t group);
+        int32_t GetPortGroup(PORT_INDEX index) const;
+
+        uint64_t GetParameterHash() const;
+        void SetParameterHash(uint64_t hash);
+        CELL_NAME GetBaseName() const; // own name for parsed cells
+        void SetBaseName(const CELL_NAME& name);
+
+        // same ports, nets and devices under another name, quotes still point to the cells of this netlist
+        std::shared_ptr<Cell> Copy(const CELL_NAME& name) const;
+        void Freeze(); // drop _portsMap and parse-only device state, shrink containers
+
         void Show();
 };
\ No newline at end of file
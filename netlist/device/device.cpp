@@ -47,10 +47,49 @@ void Device::AddConnectNet(const std::shared_ptr<Net>& net, const PIN_MAGIC& pin
     net->GetConnectDevices().emplace_front(std::make_pair(shared_from_this(), pinMagic));
 }
 
+void Device::SetPinMagic(size_t pin, PIN_MAGIC pinMagic) {
+    auto& [net, oldMagic] = _connectNets[pin];
+    for (auto& connect : net->GetConnectDevices()) {
+        if (connect.second == oldMagic && connect.first.lock().get() == this) {
+            connect.second = pinMagic;
+            break;
+        }
+    }
+    oldMagic = pinMagic;
+}
+
 bool Device::PropertyCompare(const std::shared_ptr<Device>& another) {
     return true;
 }
 
+std::vector<double> Device::GetSizes() const {
+    return {};
+}
+
+void Device::Compact() {
+    _connectNets.shrink_to_fit();
+    decltype(_expressions)().swap(_expressions); // cells are specialized in Netlist::Prepare
+}
+
+void Device::RecordExpression(const PROPERTY_NAME& propertyName, const std::string& expression) {
+    for (auto& it : _expressions) {
+        if (MatchNoCase(it.first, propertyName)) {
+            it.second = expression;
+            return;
+        }
+    }
+    _expressions.emplace_back(propertyName, expression);
+}
+
+void Device::SolveExpressions(
+    std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
+    std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam) {
+    const std::vector<std::pair<PROPERTY_NAME, std::string> > expressions = _expressions;
+    for (const auto& [propertyName, expression] : expressions) {
+        SetPropertyValue(propertyName, expression, localParam, globalParam);
+    }
+}
+
 // 留作派生类重载使用
 // std::shared_ptr<Device> Device::CopyDevice(
 //     const std::shared_ptr<Cell>& parentCell,
@@ -16,6 +16,7 @@ protected:
     std::weak_ptr<Netlist> _netlist;
     std::weak_ptr<Cell> _cell;
     std::vector<std::pair<std::shared_ptr<Net>, PIN_MAGIC> > _connectNets;
+    std::vector<std::pair<PROPERTY_NAME, std::string> > _expressions; // properties of parameterized cells, solved again per specialization
 
 public:
     Device() = default;
@@ -40,11 +41,18 @@ public:
 
     std::vector<std::pair<std::shared_ptr<Net>, PIN_MAGIC> >& GetConnectNets();
     void AddConnectNet(const std::shared_ptr<Net>& net, const PIN_MAGIC& pinMagic);
+    void SetPinMagic(size_t pin, PIN_MAGIC pinMagic); // in the connect list of the net too
 
     virtual void SetPropertyValue(const PROPERTY_NAME& propertyName, const std::string& expression,
         std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
         std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam) = 0;
     virtual std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> GetProperties() = 0;
     virtual bool PropertyCompare(const std::shared_ptr<Device>& another);
+    virtual std::vector<double> GetSizes() const; // numeric properties used by initial coloring
+    void RecordExpression(const PROPERTY_NAME& propertyName, const std::string& expression);
+    void SolveExpressions(
+        std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
+        std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam);
     virtual std::shared_ptr<Device> CopyDevice(const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) = 0;
+    virtual void Compact(); // drop parse-only state, see Netlist::Freeze
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <functional>
+#include "gate.h"
+
+Gate::Gate(const DEVICE_NAME& name, const DEVICE_TYPE& type) {
+    _name = name;
+    _deviceType = type;
+}
+
+void Gate::SetInputs(const std::vector<INPUT_COMPONENTS>& inputs) {
+    _inputs = inputs;
+}
+
+void Gate::SetPropertyValue([[maybe_unused]] const PROPERTY_NAME& propertyName, [[maybe_unused]] const std::string& expression,
+    [[maybe_unused]] std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
+    [[maybe_unused]] std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam
+) {
+    // gate properties come from its components
+}
+
+std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> Gate::GetProperties() {
+    std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> result;
+    for (const INPUT_COMPONENTS& input : _inputs) {
+        for (const std::shared_ptr<Device>& component : {input.first, input.second}) {
+            for (const auto& item : component->GetProperties()) {
+                result.emplace(component->GetName() + "." + item.first, item.second);
+            }
+        }
+    }
+    return result;
+}
+
+bool Gate::InputCompare(const INPUT_COMPONENTS& input1, const INPUT_COMPONENTS& input2) const {
+    return input1.first->PropertyCompare(input2.first) && input1.second->PropertyCompare(input2.second);
+}
+
+bool Gate::PropertyCompare(const std::shared_ptr<Device>& another) {
+    if (another->GetDeviceType() != _deviceType) {
+        return false;
+    }
+
+    const std::shared_ptr<Gate> gate = std::dynamic_pointer_cast<Gate>(another);
+    if (gate == nullptr || _inputs.size() != gate->_inputs.size()) {
+        return false;
+    }
+
+    // inputs are permutable, but the pmos and nmos of one input stay together: a perfect matching of
+    // the inputs, found by augmenting paths since a first fit within the tolerance may block a valid one
+    std::vector<size_t> partner(gate->_inputs.size(), SIZE_MAX); // input of this gate matched to each input of another
+    std::vector<bool> visited;
+    std::function<bool(size_t)> Augment = [&](size_t input) {
+        for (size_t i = 0; i < gate->_inputs.size(); ++i) {
+            if (visited[i] || !InputCompare(_inputs[input], gate->_inputs[i])) {
+                continue;
+            }
+            visited[i] = true;
+            if (partner[i] == SIZE_MAX || Augment(partner[i])) {
+                partner[i] = input;
+                return true;
+            }
+        }
+        return false;
+    };
+    for (size_t input = 0; input < _inputs.size(); ++input) {
+        visited.assign(gate->_inputs.size(), false);
+        if (!Augment(input)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<double> Gate::GetSizes() const {
+    // one tuple per input, pmos W/L then nmos W/L; the tuples are sorted whole, so permuted inputs give the
+    // same vector and no W is paired with the L of another component
+    std::vector<std::vector<double> > tuples;
+    for (const INPUT_COMPONENTS& input : _inputs) {
+        std::vector<double> tuple = input.first->GetSizes();
+        const std::vector<double> nSizes = input.second->GetSizes();
+        tuple.insert(tuple.end(), nSizes.begin(), nSizes.end());
+        tuples.emplace_back(std::move(tuple));
+    }
+    std::sort(tuples.begin(), tuples.end());
+
+    std::vector<double> result;
+    for (const std::vector<double>& tuple : tuples) {
+        result.insert(result.end(), tuple.begin(), tuple.end());
+    }
+    return result;
+}
+
+std::shared_ptr<Device> Gate::CopyDevice(const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) {
+    const std::shared_ptr<Gate>& parentDevice = std::make_shared<Gate>(parentDeviceName, _deviceType);
+    parentDevice->SetCell(parentCell);
+    parentDevice->SetNetlist(_netlist.lock());
+    parentDevice->SetModel(_model);
+    parentDevice->_inputs = _inputs; // components are only read after recognition
+    return parentDevice;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "device.h"
+
+// composite device made of recognized mosfets, e.g. INV/NAND2/NOR2/TG
+class Gate: public Device {
+public:
+    typedef std::pair<std::shared_ptr<Device>, std::shared_ptr<Device> > INPUT_COMPONENTS; // pmos, nmos driven by one input
+private:
+    std::vector<INPUT_COMPONENTS> _inputs; // the TG has one, its channel pair
+private:
+    bool InputCompare(const INPUT_COMPONENTS& input1, const INPUT_COMPONENTS& input2) const;
+public:
+    Gate(const DEVICE_NAME& name, const DEVICE_TYPE& type);
+    Gate(const Gate&) = delete;
+    Gate& operator=(const Gate&) = delete;
+
+    void SetInputs(const std::vector<INPUT_COMPONENTS>& inputs);
+
+    void SetPropertyValue(const PROPERTY_NAME& propertyName, const std::string& expression,
+        std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
+        std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam) override;
+    std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> GetProperties() override;
+    bool PropertyCompare(const std::shared_ptr<Device>& another) override;
+    std::vector<double> GetSizes() const override;
+    std::shared_ptr<Device> CopyDevice(const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) override;
+};
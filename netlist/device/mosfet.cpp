@@ -9,6 +9,9 @@ Mosfet::Mosfet(const DEVICE_NAME& name) {
 void Mosfet::SetPropertyValue(const PROPERTY_NAME& propertyName, const std::string& expression,
         std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
         std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam) {
+    if (!localParam.empty()) {
+        RecordExpression(propertyName, expression); // may depend on instance parameters
+    }
     Expression exp;
     std::variant<double, std::string> expResult = exp.SolveExpression(expression, localParam, globalParam);
 
@@ -39,6 +42,10 @@ bool Mosfet::PropertyCompare(const std::shared_ptr<Device>& another) {
     return std::fabs(_w - device->_w) <= tolerance && std::fabs(_l - device->_l) <= tolerance;
 }
 
+std::vector<double> Mosfet::GetSizes() const {
+    return {_w, _l};
+}
+
 std::shared_ptr<Device> Mosfet::CopyDevice( const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) {
     const std::shared_ptr<Mosfet>& parentDevice = std::make_shared<Mosfet>(parentDeviceName);
     parentDevice->SetCell(parentCell);
@@ -46,6 +53,7 @@ std::shared_ptr<Device> Mosfet::CopyDevice( const std::shared_ptr<Cell>& parentC
     parentDevice->SetModel(_model);
     parentDevice->_w = _w;
     parentDevice->_l = _l;
+    parentDevice->_expressions = _expressions;
     // other parameters should be copied if needed
     return parentDevice;
 }
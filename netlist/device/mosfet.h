@@ -14,5 +14,6 @@ public:
         std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam) override;
     std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> GetProperties() override;
     bool PropertyCompare(const std::shared_ptr<Device>& another) override;
+    std::vector<double> GetSizes() const override;
     std::shared_ptr<Device> CopyDevice(const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) override;
 };
\ No newline at end of file
@@ -18,10 +18,17 @@ void Quote::SetQuoteCell(const std::shared_ptr<Cell>& cell) {
 }
 
 void Quote::SetPropertyValue(const PROPERTY_NAME& propertyName, const std::string& expression,
-    std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
-    std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam
+    [[maybe_unused]] std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& localParam,
+    [[maybe_unused]] std::unordered_map<PARAMETER_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& globalParam
 ) {
-    // quote has no properties
+    // instance parameters are solved later, in the resolved parameters of the parent cell
+    for (auto& it : _parameterExpressions) {
+        if (MatchNoCase(it.first, propertyName)) {
+            it.second = expression;
+            return;
+        }
+    }
+    _parameterExpressions.emplace_back(propertyName, expression);
 }
 
 std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> Quote::GetProperties() {
@@ -35,5 +42,18 @@ std::shared_ptr<Device> Quote::CopyDevice(const std::shared_ptr<Cell>& parentCel
     parentDevice->SetNetlist(_netlist.lock());
     parentDevice->SetModel(_model);
     parentDevice->SetQuoteCell(_quoteCell.lock());
+    parentDevice->_parameterExpressions = _parameterExpressions;
     return parentDevice;
 }
+
+void Quote::Compact() {
+    Device::Compact();
+    decltype(_tokens)().swap(_tokens);
+    decltype(_parameterExpressions)().swap(_parameterExpressions);
+    // pins bound as a device no longer need the pending list
+    if (!_connectNets.empty() && _connectNets.size() == _pendingNets.size()) {
+        decltype(_pendingNets)().swap(_pendingNets);
+    } else {
+        _pendingNets.shrink_to_fit();
+    }
+}
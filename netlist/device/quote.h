@@ -12,6 +12,7 @@ public:
 
     std::vector<std::string> _tokens;
     std::vector<std::shared_ptr<Net>> _pendingNets;
+    std::vector<std::pair<PARAMETER_NAME, std::string> > _parameterExpressions; // instance overrides, solved in the parent by Netlist::SpecializeCells
 
     std::shared_ptr<Cell> GetQuoteCell() const;
     void SetQuoteCell(const std::shared_ptr<Cell>& cell);
@@ -22,4 +23,5 @@ public:
     std::unordered_map<PROPERTY_NAME, std::variant<double, std::string>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> GetProperties() override;
     // bool PropertyCompare(const std::shared_ptr<Device>& another) override;
     std::shared_ptr<Device> CopyDevice(const std::shared_ptr<Cell>& parentCell, const CELL_NAME& parentDeviceName) override;
+    void Compact() override;
 };
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include "gate_recognizer.h"
+
+static std::string GetGateTypeName(DEVICE_TYPE type) {
+    switch (type) {
+        case DEVICE_TYPE_GATE_INV:
+            return "INV";
+        case DEVICE_TYPE_GATE_NAND2:
+            return "NAND2";
+        case DEVICE_TYPE_GATE_NOR2:
+            return "NOR2";
+        case DEVICE_TYPE_GATE_TG:
+            return "TG";
+        default:
+            return std::to_string(type);
+    }
+}
+
+GateRecognizer::GateRecognizer(const std::shared_ptr<Cell>& cell): _cell(cell) {}
+
+GateRecognizer::POLARITY GateRecognizer::GetPolarity(const DEVICE_MODEL_NAME& model) {
+    const Config& config = Config::GetInstance();
+    for (const std::string& prefix : config.nmosModels) {
+        if (StartWithNoCase(model, prefix)) {
+            return POLARITY_N;
+        }
+    }
+    for (const std::string& prefix : config.pmosModels) {
+        if (StartWithNoCase(model, prefix)) {
+            return POLARITY_P;
+        }
+    }
+    return POLARITY_UNKNOWN;
+}
+
+void GateRecognizer::LoadTransistors() {
+    for (const std::shared_ptr<Port>& port : _cell->GetPorts()) {
+        if (port->GetNet() != nullptr) {
+            _externalNets.insert(port->GetNet());
+        }
+    }
+
+    for (const auto& it : _cell->GetDevices()) {
+        const std::shared_ptr<Device>& device = it.second;
+        std::vector<std::pair<std::shared_ptr<Net>, PIN_MAGIC> >& connectNets = device->GetConnectNets();
+
+        if (device->GetDeviceType() != DEVICE_TYPE_MOSFET || connectNets.size() != 4) {
+            // quotes and other devices make their nets visible outside of any gate
+            for (const auto& it2 : connectNets) {
+                _externalNets.insert(it2.first);
+            }
+            if (device->GetDeviceType() == DEVICE_TYPE_QUOTE) {
+                for (const std::shared_ptr<Net>& net : std::dynamic_pointer_cast<Quote>(device)->_pendingNets) {
+                    _externalNets.insert(net);
+                }
+            }
+            continue;
+        }
+
+        // mosfet pins: drain gate source bulk
+        Transistor transistor{device, GetPolarity(device->GetModel()),
+                              connectNets[0].first, connectNets[1].first, connectNets[2].first, connectNets[3].first, false};
+        transistor.used = transistor.polarity == POLARITY_UNKNOWN; // still blocks its nets from any gate
+        _transistors.emplace_back(transistor);
+
+        const size_t index = _transistors.size() - 1;
+        _channelUsers[transistor.drain].emplace_back(index);
+        _channelUsers[transistor.source].emplace_back(index);
+        _gateNets.insert(transistor.gate);
+        _externalNets.insert(transistor.bulk);
+    }
+}
+
+bool GateRecognizer::IsInternal(const std::shared_ptr<Net>& net) const {
+    return net->GetPortIndex() == NOT_PORT && !_externalNets.count(net) && !_gateNets.count(net);
+}
+
+void GateRecognizer::RecognizeSeries(POLARITY seriesPolarity) {
+    // NAND2: two nmos in series, two pmos in parallel; NOR2 is the dual
+    const POLARITY parallelPolarity = seriesPolarity == POLARITY_N ? POLARITY_P : POLARITY_N;
+
+    for (const auto& it : _channelUsers) {
+        const std::shared_ptr<Net>& middle = it.first;
+        const std::vector<size_t>& users = it.second;
+        if (users.size() != 2 || users[0] == users[1] || !IsInternal(middle)) {
+            continue;
+        }
+
+        const Transistor& s1 = _transistors[users[0]];
+        const Transistor& s2 = _transistors[users[1]];
+        if (s1.used || s2.used || s1.polarity != seriesPolarity || s2.polarity != seriesPolarity || s1.bulk != s2.bulk) {
+            continue;
+        }
+
+        const std::shared_ptr<Net> end1 = s1.Other(middle), end2 = s2.Other(middle);
+        if (end1 == middle || end2 == middle || end1 == end2) {
+            continue;
+        }
+
+        for (const auto& [out, rail] : {std::make_pair(end1, end2), std::make_pair(end2, end1)}) {
+            const std::vector<size_t>& outUsers = _channelUsers[out];
+            if (outUsers.size() != 3) {
+                continue;
+            }
+
+            std::vector<size_t> parallel;
+            for (size_t user : outUsers) {
+                if (user != users[0] && user != users[1]) {
+                    parallel.emplace_back(user);
+                }
+            }
+            if (parallel.size() != 2 || parallel[0] == parallel[1]) {
+                continue;
+            }
+
+            if (_transistors[parallel[0]].gate != s1.gate) {
+                std::swap(parallel[0], parallel[1]); // parallel[k] and users[k] share an input
+            }
+            const Transistor& q1 = _transistors[parallel[0]];
+            const Transistor& q2 = _transistors[parallel[1]];
+            const std::shared_ptr<Net> otherRail = q1.Other(out);
+            if (q1.used || q2.used || q1.polarity != parallelPolarity || q2.polarity != parallelPolarity
+                || q1.bulk != q2.bulk || q2.Other(out) != otherRail || otherRail == out || otherRail == rail) {
+                continue;
+            }
+            if (!((q1.gate == s1.gate && q2.gate == s2.gate) || (q1.gate == s2.gate && q2.gate == s1.gate))) {
+                continue;
+            }
+
+            const bool nand = seriesPolarity == POLARITY_N;
+            const std::shared_ptr<Net>& vdd = nand ? otherRail : rail;
+            const std::shared_ptr<Net>& vss = nand ? rail : otherRail;
+            const std::shared_ptr<Net>& pBulk = nand ? q1.bulk : s1.bulk;
+            const std::shared_ptr<Net>& nBulk = nand ? s1.bulk : q1.bulk;
+            const std::vector<size_t> series = {users[0], users[1]};
+
+            BuildGate(nand ? DEVICE_TYPE_GATE_NAND2 : DEVICE_TYPE_GATE_NOR2,
+                      nand ? parallel : series, nand ? series : parallel,
+                      {s1.gate, s2.gate, out, vdd, vss, pBulk, nBulk}, middle);
+            break;
+        }
+    }
+}
+
+void GateRecognizer::RecognizeInverters() {
+    for (const auto& it : _channelUsers) {
+        const std::shared_ptr<Net>& out = it.first;
+        const std::vector<size_t>& users = it.second;
+        if (users.size() != 2 || users[0] == users[1]) {
+            continue;
+        }
+
+        size_t pIndex = users[0], nIndex = users[1];
+        if (_transistors[pIndex].polarity != POLARITY_P) {
+            std::swap(pIndex, nIndex);
+        }
+        const Transistor& p = _transistors[pIndex];
+        const Transistor& n = _transistors[nIndex];
+        if (p.used || n.used || p.polarity != POLARITY_P || n.polarity != POLARITY_N || p.gate != n.gate || p.gate == out) {
+            continue;
+        }
+
+        const std::shared_ptr<Net> vdd = p.Other(out), vss = n.Other(out);
+        if (vdd == out || vss == out || vdd == vss) {
+            continue;
+        }
+
+        BuildGate(DEVICE_TYPE_GATE_INV, {pIndex}, {nIndex}, {p.gate, out, vdd, vss, p.bulk, n.bulk}, nullptr);
+    }
+}
+
+void GateRecognizer::RecognizeTransmissionGates() {
+    std::map<std::pair<Net*, Net*>, std::vector<size_t> > channels[3]; // indexed by polarity
+    for (size_t i = 0; i < _transistors.size(); ++i) {
+        const Transistor& transistor = _transistors[i];
+        if (transistor.used || transistor.drain == transistor.source) {
+            continue;
+        }
+        Net* end1 = transistor.drain.get();
+        Net* end2 = transistor.source.get();
+        channels[transistor.polarity][std::minmax(end1, end2)].emplace_back(i);
+    }
+
+    for (const auto& it : channels[POLARITY_N]) {
+        const auto itP = channels[POLARITY_P].find(it.first);
+        if (itP == channels[POLARITY_P].end()) {
+            continue;
+        }
+
+        std::vector<size_t>& pIndexes = itP->second;
+        for (size_t nIndex : it.second) {
+            const Transistor& n = _transistors[nIndex];
+            for (size_t pIndex : pIndexes) {
+                const Transistor& p = _transistors[pIndex];
+                if (p.used || p.gate == n.gate || n.gate == n.drain || n.gate == n.source
+                    || p.gate == p.drain || p.gate == p.source) {
+                    continue;
+                }
+                BuildGate(DEVICE_TYPE_GATE_TG, {pIndex}, {nIndex}, {n.drain, n.source, n.gate, p.gate, p.bulk, n.bulk}, nullptr);
+                break;
+            }
+        }
+    }
+}
+
+void GateRecognizer::BuildGate(DEVICE_TYPE type, const std::vector<size_t>& pmos, const std::vector<size_t>& nmos,
+                               const std::vector<std::shared_ptr<Net> >& nets, const std::shared_ptr<Net>& internalNet) {
+    std::vector<std::shared_ptr<Device> > pDevices, nDevices;
+    DEVICE_NAME name = GetGateTypeName(type) + "(";
+
+    for (const std::vector<size_t>* indexes : {&pmos, &nmos}) {
+        for (size_t index : *indexes) {
+            Transistor& transistor = _transistors[index];
+            const std::shared_ptr<Device>& device = transistor.device;
+            transistor.used = true;
+
+            (transistor.polarity == POLARITY_P ? pDevices : nDevices).emplace_back(device);
+            name += (name.back() == '(' ? "" : ",") + device->GetName();
+
+            for (const auto& it : device->GetConnectNets()) {
+                it.first->GetConnectDevices().remove_if(
+                    [&device](const std::pair<std::weak_ptr<Device>, PIN_MAGIC>& connect) {
+                        return connect.first.lock() == device;
+                    });
+            }
+            _cell->GetDevices().erase(device->GetName());
+        }
+    }
+    name += ")";
+
+    if (internalNet != nullptr) {
+        _cell->GetNets().erase(internalNet->GetName());
+    }
+
+    const std::shared_ptr<Gate> gate = std::make_shared<Gate>(name, type);
+    gate->SetCell(_cell);
+    gate->SetNetlist(_cell->GetNetlist());
+    gate->SetModel(GetGateTypeName(type));
+    std::vector<Gate::INPUT_COMPONENTS> inputs;
+    for (size_t i = 0; i < pDevices.size() && i < nDevices.size(); ++i) {
+        inputs.emplace_back(pDevices[i], nDevices[i]);
+    }
+    gate->SetInputs(inputs);
+
+    const std::vector<PIN_MAGIC>& pinMagics = pinMagicTable.at(type);
+    for (size_t i = 0; i < nets.size(); ++i) {
+        gate->AddConnectNet(nets[i], pinMagics[i]);
+    }
+    _cell->AddDevice(gate);
+    ++_gateNum;
+}
+
+uint32_t GateRecognizer::Recognize() {
+    LoadTransistors();
+    RecognizeSeries(POLARITY_N);
+    RecognizeSeries(POLARITY_P);
+    RecognizeInverters();
+    RecognizeTransmissionGates();
+    return _gateNum;
+}
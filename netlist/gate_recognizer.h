@@ -0,0 +1,46 @@
+#pragma once
+
+#include <unordered_set>
+#include "cell.h"
+#include "device/gate.h"
+
+// replace CMOS structures (INV/NAND2/NOR2/TG) built from mosfets by composite gates before WL
+class GateRecognizer {
+private:
+    typedef int8_t POLARITY;
+    static constexpr POLARITY POLARITY_UNKNOWN = 0;
+    static constexpr POLARITY POLARITY_N = 1;
+    static constexpr POLARITY POLARITY_P = 2;
+
+    struct Transistor {
+        std::shared_ptr<Device> device;
+        POLARITY polarity;
+        std::shared_ptr<Net> drain, gate, source, bulk;
+        bool used;
+        std::shared_ptr<Net> Other(const std::shared_ptr<Net>& net) const {
+            return drain == net ? source : drain;
+        }
+    };
+private:
+    std::shared_ptr<Cell> _cell;
+    std::vector<Transistor> _transistors;
+    std::unordered_map<std::shared_ptr<Net>, std::vector<size_t> > _channelUsers; // nets -> transistors connected by drain/source
+    std::unordered_set<std::shared_ptr<Net> > _gateNets; // nets that drive some mosfet gate
+    std::unordered_set<std::shared_ptr<Net> > _externalNets; // ports and nets used by quotes
+    uint32_t _gateNum{0};
+private:
+    static POLARITY GetPolarity(const DEVICE_MODEL_NAME& model);
+    void LoadTransistors();
+    bool IsInternal(const std::shared_ptr<Net>& net) const;
+
+    void RecognizeSeries(POLARITY seriesPolarity);
+    void RecognizeInverters();
+    void RecognizeTransmissionGates();
+
+    // pmos[i] and nmos[i] are driven by the same input
+    void BuildGate(DEVICE_TYPE type, const std::vector<size_t>& pmos, const std::vector<size_t>& nmos,
+                   const std::vector<std::shared_ptr<Net> >& nets, const std::shared_ptr<Net>& internalNet);
+public:
+    explicit GateRecognizer(const std::shared_ptr<Cell>& cell);
+    uint32_t Recognize(); // return the number of composite gates
+};
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sys/resource.h>
+#include "memory_report.h"
+#include "../parse/layout.h"
+
+// rough heap overheads of libstdc++ containers and shared_ptr control blocks
+constexpr uint64_t SHARED_PTR_BLOCK = 16;
+constexpr uint64_t LIST_NODE = 2 * sizeof(void*);
+constexpr uint64_t HASH_NODE = sizeof(void*) + sizeof(size_t);
+
+static uint64_t StringBytes(const std::string& str) {
+    return str.capacity() > 15 ? str.capacity() + 1 : 0; // short strings live inside the object
+}
+
+template <typename Map>
+static uint64_t HashMapBytes(const Map& map) {
+    return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + HASH_NODE);
+}
+
+MemoryReport& MemoryReport::GetInstance() {
+    static MemoryReport instance;
+    return instance;
+}
+
+uint64_t MemoryReport::ReadProcStatus(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const size_t keyLength = strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, keyLength, key) == 0) {
+            return std::stoull(line.substr(keyLength + 1)) * 1024;
+        }
+    }
+    return 0;
+}
+
+void MemoryReport::ResetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs.is_open()) {
+        clearRefs << "5"; // reset VmHWM
+    }
+}
+
+uint64_t MemoryReport::GetCurrentRss() {
+    return ReadProcStatus("VmRSS");
+}
+
+uint64_t MemoryReport::GetPeakRss() {
+    const uint64_t peak = ReadProcStatus("VmHWM");
+    if (peak != 0) {
+        return peak;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+void MemoryReport::MarkPhase(const std::string& phase) {
+    const PhaseUsage usage{phase, GetCurrentRss(), GetPeakRss()};
+    ResetPeakRss();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _phases.emplace_back(usage);
+}
+
+void MemoryReport::Add(const std::string& type, uint64_t count, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    TypeUsage& usage = _types[type];
+    usage.count += count;
+    usage.bytes += bytes;
+}
+
+uint64_t MemoryReport::MeasureCell(const std::shared_ptr<Cell>& cell, std::map<std::string, TypeUsage>& types) {
+    TypeUsage cellUsage, netUsage, mosfetUsage, gateUsage, quoteUsage, portUsage;
+
+    cellUsage.count = 1;
+    cellUsage.bytes = sizeof(Cell) + SHARED_PTR_BLOCK + StringBytes(cell->GetName())
+                      + HashMapBytes(cell->GetDevices()) + HashMapBytes(cell->GetNets()) + HashMapBytes(cell->GetParameters())
+                      + HashMapBytes(cell->_portsMap) + HashMapBytes(cell->_sons)
+                      + cell->GetPorts().capacity() * sizeof(std::shared_ptr<Port>)
+                      + cell->_parents.capacity() * sizeof(std::weak_ptr<Cell>);
+    for (const auto& it : cell->_sons) {
+        cellUsage.bytes += it.second.capacity() * sizeof(std::shared_ptr<Quote>);
+    }
+
+    for (const auto& it : cell->GetNets()) {
+        const std::shared_ptr<Net>& net = it.second;
+        ++netUsage.count;
+        netUsage.bytes += sizeof(Net) + SHARED_PTR_BLOCK + StringBytes(net->GetName())
+                          + net->GetConnectDevices().size() * (sizeof(std::pair<std::weak_ptr<Device>, PIN_MAGIC>) + LIST_NODE);
+    }
+
+    for (const auto& it : cell->GetDevices()) {
+        const std::shared_ptr<Device>& device = it.second;
+        uint64_t bytes = SHARED_PTR_BLOCK + StringBytes(device->GetName()) + StringBytes(device->GetModel())
+                         + device->GetConnectNets().capacity() * sizeof(std::pair<std::shared_ptr<Net>, PIN_MAGIC>);
+        switch (device->GetDeviceType()) {
+            case DEVICE_TYPE_MOSFET:
+                ++mosfetUsage.count;
+                mosfetUsage.bytes += bytes + sizeof(Mosfet);
+                break;
+            case DEVICE_TYPE_QUOTE: {
+                const std::shared_ptr<Quote> quote = std::dynamic_pointer_cast<Quote>(device);
+                bytes += sizeof(Quote) + quote->_pendingNets.capacity() * sizeof(std::shared_ptr<Net>)
+                         + quote->_tokens.capacity() * sizeof(std::string);
+                for (const std::string& token : quote->_tokens) {
+                    bytes += StringBytes(token);
+                }
+                ++quoteUsage.count;
+                quoteUsage.bytes += bytes;
+                break;
+            }
+            default:
+                ++gateUsage.count;
+                gateUsage.bytes += bytes + sizeof(Gate);
+                break;
+        }
+    }
+
+    for (const std::shared_ptr<Port>& port : cell->GetPorts()) {
+        ++portUsage.count;
+        portUsage.bytes += sizeof(Port) + SHARED_PTR_BLOCK + StringBytes(port->GetName());
+    }
+
+    for (const auto& [type, usage] : {std::make_pair("Cell", cellUsage), std::make_pair("Net", netUsage),
+                                      std::make_pair("Mosfet", mosfetUsage), std::make_pair("Gate", gateUsage),
+                                      std::make_pair("Quote", quoteUsage), std::make_pair("Port", portUsage)}) {
+        types[type].count += usage.count;
+        types[type].bytes += usage.bytes;
+    }
+    return cellUsage.bytes + netUsage.bytes + mosfetUsage.bytes + gateUsage.bytes + quoteUsage.bytes + portUsage.bytes;
+}
+
+uint64_t MemoryReport::AccountCell(const std::shared_ptr<Cell>& cell) {
+    std::map<std::string, TypeUsage> types;
+    const uint64_t workingSet = MeasureCell(cell, types);
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& [type, usage] : types) {
+        _types[type].count += usage.count;
+        _types[type].bytes += usage.bytes;
+    }
+    _cells.emplace_back(cell->GetName(), workingSet);
+    return workingSet;
+}
+
+uint64_t MemoryReport::EstimateNetlist(const std::shared_ptr<Netlist>& netlist) {
+    std::map<std::string, TypeUsage> types;
+    uint64_t bytes = sizeof(Netlist) + HashMapBytes(netlist->_cells) + HashMapBytes(netlist->_validCells);
+    for (const auto& it : netlist->_cells) {
+        bytes += MeasureCell(it.second, types);
+    }
+    return bytes;
+}
+
+void MemoryReport::AccountNetlist(const std::shared_ptr<Netlist>& netlist) {
+    Add("Netlist", 1, sizeof(Netlist) + HashMapBytes(netlist->_cells) + HashMapBytes(netlist->_validCells));
+    if (netlist->_layout != nullptr) {
+        Add("Layout", netlist->_layout->GetPlacementNum(), netlist->_layout->GetMemorySize());
+    }
+    for (const auto& it : netlist->_cells) {
+        AccountCell(it.second);
+    }
+}
+
+void MemoryReport::Clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _types.clear();
+    _cells.clear();
+}
+
+std::map<std::string, MemoryReport::TypeUsage> MemoryReport::GetTypes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _types;
+}
+
+std::string MemoryReport::ToString(size_t topCells) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::ostringstream out;
+    auto MB = [](uint64_t bytes) {
+        return bytes / (1024.0 * 1024.0);
+    };
+
+    out << "==== memory by type ====" << std::endl;
+    for (const auto& [type, usage] : _types) {
+        out << type << ": " << usage.count << " objects, " << MB(usage.bytes) << " MB" << std::endl;
+    }
+
+    out << "==== memory by phase ====" << std::endl;
+    for (const PhaseUsage& phase : _phases) {
+        out << phase.phase << ": rss " << MB(phase.rss) << " MB, peak " << MB(phase.peakRss) << " MB" << std::endl;
+    }
+
+    std::vector<std::pair<CELL_NAME, uint64_t> > cells = _cells;
+    topCells = std::min(topCells, cells.size());
+    std::partial_sort(cells.begin(), cells.begin() + topCells, cells.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+    });
+    out << "==== largest cells ====" << std::endl;
+    for (size_t i = 0; i < topCells; ++i) {
+        out << cells[i].first << ": " << MB(cells[i].second) << " MB" << std::endl;
+    }
+    return out.str();
+}
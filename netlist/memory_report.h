@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include "netlist.h"
+#include "device/gate.h"
+
+// Estimated bytes and object counts per netlist structure, plus RSS per phase.
+// Walking the netlist is linear and only happens at phase marks, so it can stay on in production.
+class MemoryReport {
+    public:
+        struct TypeUsage {
+            uint64_t count = 0;
+            uint64_t bytes = 0;
+        };
+    private:
+        struct PhaseUsage {
+            std::string phase;
+            uint64_t rss;
+            uint64_t peakRss; // peak inside the phase when the kernel allows to reset it, else since start
+        };
+    private:
+        std::mutex _mutex;
+        std::map<std::string, TypeUsage> _types;
+        std::vector<PhaseUsage> _phases;
+        std::vector<std::pair<CELL_NAME, uint64_t> > _cells; // working set of every accounted cell
+    private:
+        MemoryReport() = default;
+        static uint64_t ReadProcStatus(const char* key); // kB field of /proc/self/status in bytes
+        static void ResetPeakRss();
+        static uint64_t MeasureCell(const std::shared_ptr<Cell>& cell, std::map<std::string, TypeUsage>& types);
+    public:
+        static MemoryReport& GetInstance();
+        static uint64_t GetCurrentRss();
+        static uint64_t GetPeakRss();
+
+        void MarkPhase(const std::string& phase); // call at the end of every phase
+        void AccountNetlist(const std::shared_ptr<Netlist>& netlist);
+        uint64_t AccountCell(const std::shared_ptr<Cell>& cell); // return the working set of the cell
+        static uint64_t EstimateNetlist(const std::shared_ptr<Netlist>& netlist); // same estimate, nothing recorded
+        void Add(const std::string& type, uint64_t count, uint64_t bytes);
+        void Clear();
+
+        std::map<std::string, TypeUsage> GetTypes();
+        std::string ToString(size_t topCells = 10);
+};
@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <map>
 #include <queue>
+#include <sstream>
 #include "netlist.h"
+#include "gate_recognizer.h"
+#include "memory_report.h"
+#include "../base/profile.h"
 
 void Netlist::SetID(const NETLIST_ID& id) {
     _id = id;
@@ -13,11 +19,508 @@ std::shared_ptr<Cell> Netlist::GetTopCell() const {
     return _topCell;
 }
 
+std::shared_ptr<Layout> Netlist::GetLayout() const {
+    return _layout;
+}
+
+void Netlist::SetLayout(const std::shared_ptr<Layout>& layout) {
+    _layout = layout;
+}
+
+void Netlist::ResetHierarchyStructure() {
+    for (const auto& it : _cells) {
+        const std::shared_ptr<Cell>& cell = it.second;
+        cell->_sons.clear();
+        cell->_parents.clear();
+        cell->_inDegree = 0;
+        cell->_outDegree = 0;
+    }
+    _validCells.clear();
+}
+
+READ_STATE Netlist::SetTopCell(const CELL_NAME& name) {
+    const std::shared_ptr<Cell> cell = FindCell(name);
+    if (cell == nullptr) {
+        return QUOTE_CANT_FIND_CELL;
+    }
+
+    ResetHierarchyStructure();
+    _topCell = cell;
+    return BuildHierarchyStructure() ? READ_OK : HIERARCHY_LOOP;
+}
+
+READ_STATE Netlist::SetTopCells(const std::vector<CELL_NAME>& names) {
+    std::shared_ptr<Cell> batchTop = FindCell(BATCH_TOP_CELL);
+    if (batchTop == nullptr) {
+        batchTop = DefineCell(BATCH_TOP_CELL);
+    }
+    batchTop->GetQuotes().clear();
+    batchTop->GetDevices().clear();
+    batchTop->GetNets().clear();
+
+    // instances only differ by index, so both netlists get the same synthetic top
+    for (size_t i = 0; i < names.size(); ++i) {
+        const std::shared_ptr<Cell> cell = FindCell(names[i]);
+        if (cell == nullptr) {
+            return QUOTE_CANT_FIND_CELL;
+        }
+
+        const std::shared_ptr<Quote> quote = std::make_shared<Quote>("X" + std::to_string(i));
+        quote->SetCell(batchTop);
+        quote->SetNetlist(shared_from_this());
+        quote->SetModel(cell->GetName());
+        quote->SetQuoteCell(cell);
+        for (const std::shared_ptr<Port>& port : cell->GetPorts()) {
+            quote->_pendingNets.emplace_back(batchTop->DefineNet(quote->GetName() + "/" + port->GetName()));
+        }
+        batchTop->AddDevice(quote);
+        batchTop->GetQuotes().push_front(quote);
+    }
+
+    ResetHierarchyStructure();
+    _topCell = batchTop;
+    return BuildHierarchyStructure() ? READ_OK : HIERARCHY_LOOP;
+}
+
+void Netlist::AddGlobalNet(const NET_NAME& name) {
+    _globalNets.insert(name);
+}
+
+bool Netlist::IsGlobalNet(const NET_NAME& name) const {
+    if (_globalNets.count(name)) {
+        return true;
+    }
+    for (const std::string& globalNet : Config::GetInstance().globalNets) {
+        if (StringCaseInsensitiveEqual()(globalNet, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+READ_STATE Netlist::ScopeToInstancePath(const std::string& path) {
+    std::shared_ptr<Cell> cell = _topCell;
+    std::stringstream pathStream(path);
+    std::string instanceName;
+    while (std::getline(pathStream, instanceName, '/')) {
+        if (instanceName.empty()) {
+            continue;
+        }
+        const std::shared_ptr<Quote> quote = std::dynamic_pointer_cast<Quote>(cell->FindDevice(instanceName));
+        if (quote == nullptr || quote->GetQuoteCell() == nullptr) {
+            _error.errorInformation = "can't find instance " + instanceName + " of " + path + " in cell " + cell->GetName();
+            return QUOTE_CANT_FIND_CELL;
+        }
+        cell = quote->GetQuoteCell();
+    }
+
+    // ports of the scoped cell are the boundary nets, the rest of the chip leaves the hierarchy
+    return cell == _topCell ? READ_OK : SetTopCell(cell->GetName());
+}
+
+void Netlist::AdoptCell(const std::shared_ptr<Cell>& cell) {
+    const std::shared_ptr<Netlist> netlist = shared_from_this();
+    cell->SetNetlist(netlist);
+    for (const auto& it : cell->GetNets()) {
+        it.second->SetNetlist(netlist);
+    }
+    for (const auto& it : cell->GetDevices()) {
+        it.second->SetNetlist(netlist);
+    }
+}
+
+READ_STATE Netlist::RelinkQuotes() {
+    for (const auto& it : _cells) {
+        const READ_STATE readState = RelinkQuotes(it.second);
+        if (readState != READ_OK) {
+            return readState;
+        }
+    }
+    return READ_OK;
+}
+
+READ_STATE Netlist::RelinkQuotes(const std::shared_ptr<Cell>& cell) {
+    for (const std::shared_ptr<Quote>& quote : cell->GetQuotes()) {
+        const std::shared_ptr<Cell> oldCell = quote->GetQuoteCell();
+        const std::shared_ptr<Cell> newCell = oldCell == nullptr ? nullptr : FindCell(oldCell->GetName());
+        if (newCell == nullptr) {
+            _error.errorInformation = quote->GetName() + " can't find cell.";
+            return QUOTE_CANT_FIND_CELL;
+        }
+        if (newCell->GetPorts().size() != quote->_pendingNets.size()) {
+            return QUOTE_PORT_NUMBER_ERROR;
+        }
+        quote->SetQuoteCell(newCell);
+    }
+    return READ_OK;
+}
+
+std::shared_ptr<Netlist> Netlist::Clone() const {
+    const std::shared_ptr<Netlist> netlist = std::make_shared<Netlist>();
+    netlist->_id = _id;
+    netlist->_globalNets = _globalNets;
+    netlist->_layout = _layout; // read only
+    netlist->_globalParameters = _globalParameters;
+    for (const auto& it : _cells) {
+        const std::shared_ptr<Cell> cell = it.second->Copy(it.second->GetName());
+        netlist->AdoptCell(cell);
+        netlist->_cells[it.first] = cell;
+    }
+
+    if (netlist->RelinkQuotes() != READ_OK || _topCell == nullptr) {
+        return nullptr;
+    }
+    netlist->_topCell = netlist->FindCell(_topCell->GetName());
+    return netlist->BuildHierarchyStructure() ? netlist : nullptr;
+}
+
+READ_STATE Netlist::SpliceCells(const std::shared_ptr<Netlist>& patch, const std::vector<CELL_NAME>& changed, const std::vector<CELL_NAME>& removed) {
+    // only the parents of a replaced cell quote it, every other cell keeps its links
+    std::vector<std::shared_ptr<Cell> > oldCells;
+    std::unordered_set<std::shared_ptr<Cell> > parents;
+    for (const std::vector<CELL_NAME>* names : {&removed, &changed}) {
+        for (const CELL_NAME& name : *names) {
+            const std::shared_ptr<Cell> oldCell = FindCell(name);
+            if (oldCell == nullptr) {
+                continue;
+            }
+            oldCells.emplace_back(oldCell);
+            for (const std::weak_ptr<Cell>& weakParent : oldCell->_parents) {
+                if (const std::shared_ptr<Cell> parent = weakParent.lock()) {
+                    parents.insert(parent);
+                }
+            }
+        }
+    }
+    for (const CELL_NAME& name : removed) {
+        _cells.erase(name);
+    }
+    for (const CELL_NAME& name : changed) {
+        const std::shared_ptr<Cell> cell = patch->FindCell(name);
+        if (cell == nullptr) {
+            return QUOTE_CANT_FIND_CELL;
+        }
+        AdoptCell(cell);
+        _cells[name] = cell;
+    }
+    for (const std::shared_ptr<Cell>& oldCell : oldCells) {
+        parents.erase(oldCell);
+    }
+
+    // the changed cells quote the stubs of the patch
+    for (const CELL_NAME& name : changed) {
+        const READ_STATE readState = RelinkQuotes(FindCell(name));
+        if (readState != READ_OK) {
+            return readState;
+        }
+    }
+    for (const std::shared_ptr<Cell>& parent : parents) {
+        const READ_STATE readState = RelinkQuotes(parent);
+        if (readState != READ_OK) {
+            return readState;
+        }
+    }
+    return RebuildHierarchy(oldCells, parents);
+}
+
+READ_STATE Netlist::RebuildHierarchy(const std::vector<std::shared_ptr<Cell> >& oldCells, const std::unordered_set<std::shared_ptr<Cell> >& parents) {
+    ScopedTimer timer("RebuildHierarchy");
+    const std::shared_ptr<Cell> topCell = FindCell(_topCell->GetName());
+    if (topCell == nullptr) {
+        return QUOTE_CANT_FIND_CELL;
+    }
+    _topCell = topCell;
+
+    std::vector<std::shared_ptr<Cell> > orphans; // lost a parent, leave the hierarchy if it was the last one
+    auto Unlink = [&orphans](const std::shared_ptr<Cell>& parent) {
+        for (const auto& it : parent->_sons) {
+            std::vector<std::weak_ptr<Cell> >& sonParents = it.first->_parents;
+            sonParents.erase(std::remove_if(sonParents.begin(), sonParents.end(),
+                [&parent](const std::weak_ptr<Cell>& weakParent) { return weakParent.lock() == parent; }), sonParents.end());
+            orphans.emplace_back(it.first);
+        }
+        parent->_sons.clear();
+        parent->_outDegree = 0;
+    };
+    for (const std::shared_ptr<Cell>& oldCell : oldCells) {
+        if (_validCells.erase(oldCell)) {
+            Unlink(oldCell);
+        }
+    }
+
+    std::queue<std::shared_ptr<Cell> > cellQueue; // valid cells whose sons are built again
+    for (const std::shared_ptr<Cell>& parent : parents) {
+        if (_validCells.count(parent)) {
+            Unlink(parent);
+            cellQueue.push(parent);
+        }
+    }
+    if (_validCells.insert(_topCell).second) {
+        cellQueue.push(_topCell);
+    }
+    std::vector<std::shared_ptr<Cell> > rebuilt;
+    while (!cellQueue.empty()) {
+        const std::shared_ptr<Cell> parent = cellQueue.front();
+        cellQueue.pop();
+        rebuilt.emplace_back(parent);
+        for (const std::shared_ptr<Quote>& quote : parent->GetQuotes()) {
+            const std::shared_ptr<Cell> son = quote->GetQuoteCell();
+            BuildDependencyRelationShip(parent, quote);
+            if (_validCells.insert(son).second) {
+                // outside the hierarchy its quotes were not kept up to date
+                const READ_STATE readState = RelinkQuotes(son);
+                if (readState != READ_OK) {
+                    return readState;
+                }
+                cellQueue.push(son);
+            }
+        }
+    }
+
+    while (!orphans.empty()) {
+        const std::shared_ptr<Cell> cell = orphans.back();
+        orphans.pop_back();
+        if (cell != _topCell && cell->_parents.empty() && _validCells.erase(cell)) {
+            Unlink(cell);
+        }
+    }
+    return HasLoopBelow(rebuilt) ? HIERARCHY_LOOP : READ_OK;
+}
+
+bool Netlist::HasLoopBelow(const std::vector<std::shared_ptr<Cell> >& roots) const {
+    // iterative DFS, true while a cell is on the path and false once all its sons are done
+    std::unordered_map<std::shared_ptr<Cell>, bool> onPath;
+    typedef std::unordered_map<std::shared_ptr<Cell>, std::vector<std::shared_ptr<Quote> > >::const_iterator SON_ITERATOR;
+    for (const std::shared_ptr<Cell>& root : roots) {
+        if (!onPath.emplace(root, true).second) {
+            continue;
+        }
+        std::vector<std::pair<std::shared_ptr<Cell>, SON_ITERATOR> > path = {{root, root->_sons.cbegin()}};
+        while (!path.empty()) {
+            const std::shared_ptr<Cell> cell = path.back().first;
+            if (path.back().second == cell->_sons.cend()) {
+                onPath[cell] = false;
+                path.pop_back();
+                continue;
+            }
+            const std::shared_ptr<Cell> son = (path.back().second++)->first;
+            const auto state = onPath.emplace(son, true);
+            if (state.second) {
+                path.emplace_back(son, son->_sons.cbegin());
+            } else if (state.first->second) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 std::string Netlist::OutputError() const {
     return _error.errorInformation;
 }
 
+void Netlist::Prepare() {
+    SpecializeCells();
+    ApplyPinEquivalence();
+    if (Config::GetInstance().gateLevel) {
+        RecognizeGates();
+    }
+}
+
+std::unordered_map<PARAMETER_NAME, PARAMETER_VALUE, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& Netlist::GetGlobalParameters() {
+    return _globalParameters;
+}
+
+uint32_t Netlist::SpecializeCells() {
+    ScopedTimer timer("SpecializeCells");
+    typedef std::unordered_map<PARAMETER_NAME, PARAMETER_VALUE, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> PARAMETER_MAP;
+
+    auto ResolvedKey = [](const PARAMETER_MAP& parameters) {
+        std::map<std::string, std::string> sorted;
+        for (const auto& [name, value] : parameters) {
+            std::string lowerName = name;
+            std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+            if (const double* number = std::get_if<double>(&value)) {
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.12g", *number);
+                sorted[lowerName] = buffer;
+            } else {
+                sorted[lowerName] = std::get<std::string>(value);
+            }
+        }
+        std::string key;
+        for (const auto& [name, value] : sorted) {
+            key += name + "=" + value + " ";
+        }
+        return key;
+    };
+
+    // a specialization keeps its resolved parameters, so the parameters of a visited cell are the context of its quotes
+    std::unordered_set<std::shared_ptr<Cell> > visited;
+    std::unordered_map<std::string, std::shared_ptr<Cell> > specializations; // base cell name + resolved key
+    std::unordered_map<std::string, std::shared_ptr<Cell> > instanceTargets; // parent + overrides, arrays solve once
+    std::queue<std::shared_ptr<Cell> > cellQueue;
+    uint32_t specializationNum = 0;
+
+    visited.insert(_topCell);
+    cellQueue.push(_topCell);
+    while (!cellQueue.empty()) {
+        const std::shared_ptr<Cell> cell = cellQueue.front();
+        cellQueue.pop();
+        PARAMETER_MAP& context = cell->GetParameters();
+
+        for (const std::shared_ptr<Quote>& quote : cell->GetQuotes()) {
+            // a quote already retargeted, e.g. copied along with its parent, is solved again from the parsed cell
+            std::shared_ptr<Cell> son = quote->GetQuoteCell();
+            const std::shared_ptr<Cell> base = FindCell(son->GetBaseName());
+            if (base != nullptr) {
+                son = base;
+            }
+            std::string instanceKey = std::to_string(reinterpret_cast<uintptr_t>(cell.get())) + " " + son->GetName();
+            for (const auto& [name, expression] : quote->_parameterExpressions) {
+                instanceKey += " " + name + "=" + expression;
+            }
+            const auto& targetIt = instanceTargets.find(instanceKey);
+            if (targetIt != instanceTargets.end()) {
+                quote->SetQuoteCell(targetIt->second);
+                continue;
+            }
+
+            PARAMETER_MAP resolved(son->GetParameters().begin(), son->GetParameters().end());
+            const std::string defaultKey = ResolvedKey(resolved);
+            for (const auto& [name, expression] : quote->_parameterExpressions) {
+                if (resolved.count(name)) {
+                    resolved[name] = Expression().SolveExpression(expression, context, _globalParameters);
+                }
+            }
+            const std::string key = ResolvedKey(resolved);
+
+            std::shared_ptr<Cell> target = son;
+            if (key != defaultKey) {
+                std::shared_ptr<Cell>& specialization = specializations[son->GetName() + " " + key];
+                if (specialization == nullptr) {
+                    const uint64_t hash = std::hash<std::string>()(son->GetName() + " " + key);
+                    std::ostringstream name;
+                    name << son->GetName() << "@" << std::hex << hash;
+                    specialization = son->Copy(name.str());
+                    specialization->SetParameterHash(hash);
+                    specialization->SetBaseName(son->GetName());
+                    specialization->GetParameters() = resolved;
+                    AdoptCell(specialization);
+                    for (const auto& it : specialization->GetDevices()) {
+                        it.second->SolveExpressions(resolved, _globalParameters);
+                    }
+                    _cells[specialization->GetName()] = specialization;
+                    ++specializationNum;
+                }
+                target = specialization;
+            }
+            quote->SetQuoteCell(target);
+            instanceTargets.emplace(instanceKey, target);
+            if (visited.insert(target).second) {
+                cellQueue.push(target);
+            }
+        }
+    }
+
+    if (specializationNum != 0) {
+        ResetHierarchyStructure();
+        BuildHierarchyStructure();
+    }
+    return specializationNum;
+}
+
+uint32_t Netlist::RecognizeGates() {
+    ScopedTimer timer("RecognizeGates");
+    uint32_t gateNum = 0;
+    for (const std::shared_ptr<Cell>& cell : _validCells) {
+        GateRecognizer recognizer(cell);
+        gateNum += recognizer.Recognize();
+    }
+    return gateNum;
+}
+
+uint64_t Netlist::Freeze() {
+    ScopedTimer timer("Freeze");
+    const uint64_t before = MemoryReport::EstimateNetlist(shared_from_this());
+
+    for (auto it = _cells.begin(); it != _cells.end();) {
+        if (_validCells.count(it->second)) {
+            ++it;
+        } else {
+            it = _cells.erase(it);
+        }
+    }
+    _cells.rehash(0);
+    for (const std::shared_ptr<Cell>& cell : _validCells) {
+        cell->Freeze();
+    }
+    _globalParameters.clear();
+
+    const uint64_t after = MemoryReport::EstimateNetlist(shared_from_this());
+    return before > after ? before - after : 0;
+}
+
+void Netlist::ApplyPinEquivalence() {
+    const Config& config = Config::GetInstance();
+    for (const auto& it : config.pinSwapGroups) {
+        const std::shared_ptr<Cell> cell = FindCell(it.first);
+        if (cell == nullptr) {
+            ApplyModelPinEquivalence(it.first, it.second);
+            continue;
+        }
+
+        const std::vector<std::shared_ptr<Port> >& ports = cell->GetPorts();
+        const std::vector<std::vector<std::string> >& groups = it.second;
+        for (size_t group = 0; group < groups.size(); ++group) {
+            for (const std::string& portName : groups[group]) {
+                for (PORT_INDEX index = 0; static_cast<size_t>(index) < ports.size(); ++index) {
+                    if (StringCaseInsensitiveEqual()(ports[index]->GetName(), portName)) {
+                        cell->SetPortGroup(index, group);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Netlist::ApplyModelPinEquivalence(const DEVICE_MODEL_NAME& model, const std::vector<std::vector<std::string> >& groups) {
+    // pins of one group take the pin magic of the first pin of the group
+    std::vector<std::vector<size_t> > pinGroups;
+    for (const std::vector<std::string>& group : groups) {
+        std::vector<size_t> pins;
+        for (const std::string& pin : group) {
+            if (!pin.empty() && pin.size() < 4 && pin.find_first_not_of("0123456789") == std::string::npos && std::stoul(pin) > 0) {
+                pins.emplace_back(std::stoul(pin) - 1);
+            }
+        }
+        pinGroups.emplace_back(pins);
+    }
+
+    for (const std::shared_ptr<Cell>& cell : _validCells) {
+        for (const auto& it : cell->GetDevices()) {
+            const std::shared_ptr<Device>& device = it.second;
+            if (!MatchNoCase(device->GetModel(), model) || device->GetDeviceType() == DEVICE_TYPE_QUOTE) {
+                continue;
+            }
+            const size_t pinNum = device->GetConnectNets().size();
+            for (const std::vector<size_t>& pins : pinGroups) {
+                if (pins.empty() || pins.front() >= pinNum) {
+                    continue;
+                }
+                const PIN_MAGIC pinMagic = device->GetConnectNets()[pins.front()].second;
+                for (size_t pin : pins) {
+                    if (pin < pinNum) {
+                        device->SetPinMagic(pin, pinMagic);
+                    }
+                }
+            }
+        }
+    }
+}
+
 READ_STATE Netlist::QuotePointToCell(const std::shared_ptr<Cell>& cell) {
+    ScopedTimer timer("QuotePointToCell", cell->GetName());
     for (const std::shared_ptr<Quote>& quote : cell->GetQuotes()) {
         bool quoteFindCell = false;
         for (const std::string& token : quote->_tokens) {
@@ -44,6 +547,7 @@ READ_STATE Netlist::QuotePointToCell(const std::shared_ptr<Cell>& cell) {
 }
 
 bool Netlist::BuildHierarchyStructure() {
+    ScopedTimer timer("BuildHierarchyStructure");
     std::queue<std::shared_ptr<Cell>> cellQueue;
     cellQueue.push(_topCell);
 
@@ -5,7 +5,10 @@
 #include <unordered_map>
 #include "../netlist/cell.h"
 
+constexpr const char* BATCH_TOP_CELL = "__BATCH_TOP__";
+
 class Spice;
+class Layout;
 class Netlist: public std::enable_shared_from_this<Netlist> {
     struct Error {
         int32_t errorLine;
@@ -15,6 +18,10 @@ private:
     friend class Spice;
     friend class Layout;
     friend class CompareNetlist;
+    friend class MemoryReport;
+    friend class IncrementalLoader;
+    friend class LibraryCache;
+    friend class ProcessCompare;
 private:
     Error _error;
 
@@ -22,6 +29,9 @@ private:
     std::shared_ptr<Cell> _topCell;
     std::unordered_map<CELL_NAME, std::shared_ptr<Cell>, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _cells;
     std::unordered_set<std::shared_ptr<Cell> > _validCells;
+    std::unordered_set<NET_NAME, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _globalNets;
+    std::shared_ptr<Layout> _layout; // placement annotations, nullptr unless Config::placementColoring
+    std::unordered_map<PARAMETER_NAME, PARAMETER_VALUE, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _globalParameters; // .PARAM outside subckts
 private:
     std::shared_ptr<Cell> FindCell(const CELL_NAME& name) const;
     std::shared_ptr<Cell> DefineCell(const CELL_NAME& cellName);
@@ -30,6 +40,14 @@ private:
 
     static void BuildDependencyRelationShip(const std::shared_ptr<Cell>& parent, const std::shared_ptr<Quote>& quote);
     bool JudgeLoop() const;
+
+    void AdoptCell(const std::shared_ptr<Cell>& cell);
+    READ_STATE RelinkQuotes(); // point every quote to the cell of this netlist with the same name
+    READ_STATE RelinkQuotes(const std::shared_ptr<Cell>& cell); // the quotes of one cell
+    // after SpliceCells: drop the replaced cells, rebuild the sons of the given parents and prune what is no longer quoted
+    READ_STATE RebuildHierarchy(const std::vector<std::shared_ptr<Cell> >& oldCells, const std::unordered_set<std::shared_ptr<Cell> >& parents);
+    bool HasLoopBelow(const std::vector<std::shared_ptr<Cell> >& roots) const; // only loops through the roots are found
+    void ApplyModelPinEquivalence(const DEVICE_MODEL_NAME& model, const std::vector<std::vector<std::string> >& groups); // 1-based pins
 public:
     Netlist& operator= (const Netlist&) = delete;
 
@@ -37,9 +55,32 @@ public:
     NETLIST_ID GetID() const;
 
     std::shared_ptr<Cell> GetTopCell() const;
+    void ResetHierarchyStructure();
+    READ_STATE SetTopCell(const CELL_NAME& name); // rebuild the hierarchy below another top cell
+    READ_STATE SetTopCells(const std::vector<CELL_NAME>& names); // a synthetic top quotes all of them
+    READ_STATE ScopeToInstancePath(const std::string& path); // "X1/X3" below the top cell becomes the top cell
+
+    std::shared_ptr<Netlist> Clone() const; // compare flattens cells in place, cached netlists hand out clones
+    // replace changed cells by the ones parsed into patch, drop removed cells, then rebuild the hierarchy above and below them
+    READ_STATE SpliceCells(const std::shared_ptr<Netlist>& patch, const std::vector<CELL_NAME>& changed, const std::vector<CELL_NAME>& removed);
+
+    std::shared_ptr<Layout> GetLayout() const;
+    void SetLayout(const std::shared_ptr<Layout>& layout);
+
+    void AddGlobalNet(const NET_NAME& name);
+    bool IsGlobalNet(const NET_NAME& name) const;
 
     std::string OutputError() const;
 
+    void Prepare(); // specialization, pin equivalence and gate recognition of the valid cells, after the hierarchy is built
+    std::unordered_map<PARAMETER_NAME, PARAMETER_VALUE, StringCaseInsensitiveHash, StringCaseInsensitiveEqual>& GetGlobalParameters();
+    // one copy of a parameterized cell per distinct resolved parameter set, shared by all its instances
+    uint32_t SpecializeCells(); // return the number of specializations
+    uint32_t RecognizeGates(); // return the number of composite gates
+    void ApplyPinEquivalence(); // Config::pinSwapGroups -> port groups of cells, pin magics of devices of a model
+    // between Prepare and compare: evict cells outside the hierarchy and compact the rest, return the bytes reclaimed
+    uint64_t Freeze();
+
     // test
     void Show();
     void ShowHierarchyStructure() const;
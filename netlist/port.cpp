@@ -4,6 +4,10 @@ Port::Port(const NET_NAME& name)
     : _name(name), _net(nullptr) {
 }
 
+NET_NAME Port::GetName() const {
+    return _name;
+}
+
 std::shared_ptr<Net> Port::GetNet() const {
     return _net;
 }
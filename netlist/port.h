@@ -14,6 +14,7 @@ public:
     Port(const Port&) = delete;
     Port& operator=(const Port&) = delete;
 
+    NET_NAME GetName() const;
     std::shared_ptr<Net> GetNet() const;
     void SetNet(const std::shared_ptr<Net>& net);
     HASH_VALUE GetLabel() const;
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cstring>
+#include <ios>
+#include "compressed_input.h"
+#ifdef LVS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LVS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+RingBuffer::RingBuffer(size_t capacity): _data(capacity) {}
+
+bool RingBuffer::Write(const char* data, size_t size) {
+    while (size > 0) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cvNotFull.wait(lock, [this]() { return _cancelled || _size < _data.size(); });
+        if (_cancelled) {
+            return false;
+        }
+        const size_t tail = (_head + _size) % _data.size();
+        const size_t count = std::min({size, _data.size() - _size, _data.size() - tail});
+        std::memcpy(_data.data() + tail, data, count);
+        _size += count;
+        data += count;
+        size -= count;
+        _cvNotEmpty.notify_one();
+    }
+    return true;
+}
+
+size_t RingBuffer::Read(char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cvNotEmpty.wait(lock, [this]() { return _closed || _size > 0; });
+    const size_t count = std::min({size, _size, _data.size() - _head});
+    std::memcpy(data, _data.data() + _head, count);
+    _head = (_head + count) % _data.size();
+    _size -= count;
+    _cvNotFull.notify_one();
+    return count;
+}
+
+void RingBuffer::Close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _cvNotEmpty.notify_all();
+}
+
+void RingBuffer::Cancel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cancelled = true;
+    _cvNotFull.notify_all();
+}
+
+DecompressStreambuf::DecompressStreambuf(const std::string& fileName, COMPRESSION compression): _ring(CHUNK_SIZE * 64) {
+    setg(_buffer, _buffer, _buffer);
+    _decompressor = std::thread(&DecompressStreambuf::Decompress, this, fileName, compression);
+}
+
+DecompressStreambuf::~DecompressStreambuf() {
+    _ring.Cancel();
+    _decompressor.join();
+}
+
+bool DecompressStreambuf::Failed() const {
+    return _failed;
+}
+
+DecompressStreambuf::int_type DecompressStreambuf::underflow() {
+    const size_t count = _ring.Read(_buffer, CHUNK_SIZE);
+    if (count == 0) {
+        if (Failed()) {
+            // the istream catches it and sets badbit, so readers see a cut off input as bad() at the end
+            throw std::ios_base::failure("corrupt compressed input");
+        }
+        return traits_type::eof();
+    }
+    setg(_buffer, _buffer, _buffer + count);
+    return traits_type::to_int_type(_buffer[0]);
+}
+
+void DecompressStreambuf::Decompress(const std::string& fileName, COMPRESSION compression) {
+    std::vector<char> output(CHUNK_SIZE);
+    if (compression == COMPRESSION_GZIP) {
+#ifdef LVS_HAVE_ZLIB
+        gzFile file = gzopen(fileName.c_str(), "rb");
+        _failed = file == nullptr;
+        if (file != nullptr) {
+            gzbuffer(file, CHUNK_SIZE);
+            int count;
+            while ((count = gzread(file, output.data(), static_cast<unsigned>(output.size()))) > 0 && _ring.Write(output.data(), count)) {}
+            int error = Z_OK;
+            gzerror(file, &error);
+            _failed = count < 0 || error != Z_OK; // Z_BUF_ERROR for a stream cut off before its trailer
+            gzclose(file);
+        }
+#else
+        _failed = true;
+#endif
+    } else if (compression == COMPRESSION_ZSTD) {
+#ifdef LVS_HAVE_ZSTD
+        std::ifstream file(fileName, std::ios::binary);
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+        std::vector<char> input(ZSTD_DStreamInSize());
+        bool writing = true;
+        size_t frameLeft = 1; // 0 once the last frame read is complete
+        _failed = !file.is_open();
+        while (writing) {
+            file.read(input.data(), static_cast<std::streamsize>(input.size()));
+            if (file.gcount() <= 0) {
+                break;
+            }
+            ZSTD_inBuffer in = {input.data(), static_cast<size_t>(file.gcount()), 0};
+            ZSTD_outBuffer out = {output.data(), output.size(), 0};
+            do { // a full output buffer may hold back more of the frame
+                out.pos = 0;
+                frameLeft = ZSTD_decompressStream(stream, &out, &in);
+                if (ZSTD_isError(frameLeft)) {
+                    _failed = true;
+                    writing = false;
+                    break;
+                }
+                writing = _ring.Write(output.data(), out.pos);
+            } while (writing && (in.pos < in.size || out.pos == out.size));
+        }
+        _failed = _failed || (writing && frameLeft != 0); // the file ends inside a frame
+        ZSTD_freeDStream(stream);
+#else
+        _failed = true;
+#endif
+    } else {
+        std::ifstream file(fileName, std::ios::binary);
+        while (file.read(output.data(), static_cast<std::streamsize>(output.size())) || file.gcount() > 0) {
+            if (!_ring.Write(output.data(), file.gcount())) {
+                break;
+            }
+        }
+    }
+    _ring.Close();
+}
+
+COMPRESSION DetectCompression(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    unsigned char magic[4] = {0, 0, 0, 0};
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        return COMPRESSION_GZIP;
+    }
+    if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+namespace {
+    // keeps the streambuf alive as long as the stream
+    class DecompressStream: public std::istream {
+        private:
+            std::unique_ptr<DecompressStreambuf> _streambuf;
+        public:
+            explicit DecompressStream(std::unique_ptr<DecompressStreambuf> streambuf): std::istream(streambuf.get()), _streambuf(std::move(streambuf)) {}
+    };
+}
+
+std::unique_ptr<std::istream> OpenInput(const std::string& fileName) {
+    const COMPRESSION compression = DetectCompression(fileName);
+    if (compression == COMPRESSION_NONE) {
+        std::unique_ptr<std::ifstream> file = std::make_unique<std::ifstream>(fileName);
+        return file->is_open() ? std::move(file) : nullptr;
+    }
+    return std::make_unique<DecompressStream>(std::make_unique<DecompressStreambuf>(fileName, compression));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef uint8_t COMPRESSION;
+constexpr COMPRESSION COMPRESSION_NONE = 0;
+constexpr COMPRESSION COMPRESSION_GZIP = 1; // needs LVS_HAVE_ZLIB
+constexpr COMPRESSION COMPRESSION_ZSTD = 2; // needs LVS_HAVE_ZSTD
+
+// bounded single producer single consumer byte queue, the producer blocks while it is full
+class RingBuffer {
+    private:
+        std::vector<char> _data;
+        size_t _head{0}, _size{0};
+        bool _closed{false}, _cancelled{false};
+        std::mutex _mutex;
+        std::condition_variable _cvNotFull, _cvNotEmpty;
+    public:
+        explicit RingBuffer(size_t capacity);
+        bool Write(const char* data, size_t size); // false once the reader cancelled
+        size_t Read(char* data, size_t size); // 0 at the end
+        void Close(); // no more writes
+        void Cancel(); // reader gone
+};
+
+// istream buffer over a compressed file, a decompressor thread feeds it through a RingBuffer
+class DecompressStreambuf: public std::streambuf {
+    private:
+        static constexpr size_t CHUNK_SIZE = 1 << 16;
+        RingBuffer _ring;
+        std::thread _decompressor;
+        char _buffer[CHUNK_SIZE];
+        std::atomic<bool> _failed{false};
+    private:
+        void Decompress(const std::string& fileName, COMPRESSION compression);
+    protected:
+        int_type underflow() override;
+    public:
+        DecompressStreambuf(const std::string& fileName, COMPRESSION compression);
+        ~DecompressStreambuf() override;
+        bool Failed() const; // valid at the end of the stream, underflow then throws and the istream turns bad()
+};
+
+COMPRESSION DetectCompression(const std::string& fileName); // by magic bytes
+// plain or compressed, nullptr if it can't be opened; bad() after the last line if the file didn't decompress to its end
+std::unique_ptr<std::istream> OpenInput(const std::string& fileName);
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#include "include_graph.h"
+#include "compressed_input.h"
+
+namespace {
+    std::vector<std::string> SplitTokens(const std::string& line) {
+        std::vector<std::string> tokens;
+        std::istringstream lineStream(line);
+        std::string token;
+        while (lineStream >> token) {
+            tokens.emplace_back(token);
+        }
+        return tokens;
+    }
+}
+
+std::string IncludeGraph::Resolve(const std::string& includingFile, std::string token) {
+    token.erase(std::remove_if(token.begin(), token.end(), [](char c) { return c == '\'' || c == '"'; }), token.end());
+    std::filesystem::path path(token);
+    if (path.is_relative()) {
+        path = std::filesystem::path(includingFile).parent_path() / path;
+    }
+    std::error_code error;
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path.string() : canonical.string();
+}
+
+bool IncludeGraph::Scan(const std::string& path) {
+    if (_indexes.count(path)) {
+        return true;
+    }
+    const std::unique_ptr<std::istream> input = OpenInput(path);
+    if (input == nullptr) {
+        return false;
+    }
+    std::istream& file = *input;
+    const size_t index = _files.size();
+    _indexes.emplace(path, index);
+    _files.push_back({path, {}});
+
+    std::vector<std::string> includes;
+    std::string line, header;
+    auto FlushHeader = [this, index, &header]() {
+        const std::vector<std::string> tokens = SplitTokens(header);
+        if (tokens.size() >= 2) {
+            std::string ports;
+            for (size_t i = 2; i < tokens.size() && tokens[i].find('=') == std::string::npos; ++i) {
+                ports += " " + tokens[i];
+            }
+            _files[index].subckts.emplace_back(tokens[1], ports);
+        }
+        header.clear();
+    };
+    while (std::getline(file, line)) {
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '*') {
+            continue;
+        }
+        if (!header.empty()) {
+            if (line[first] == '+') {
+                header += " " + line.substr(first + 1);
+                continue;
+            }
+            FlushHeader();
+        }
+
+        const std::vector<std::string> tokens = SplitTokens(line);
+        if (StartWithNoCase(tokens[0], ".SUBCKT")) {
+            header = line.substr(first);
+        } else if (MatchNoCase(tokens[0], ".INCLUDE") || MatchNoCase(tokens[0], ".INC")) {
+            if (tokens.size() >= 2) {
+                includes.emplace_back(Resolve(path, tokens[1]));
+            }
+        } else if (MatchNoCase(tokens[0], ".LIB") && tokens.size() >= 3) {
+            includes.emplace_back(Resolve(path, tokens[1])); // ".LIB file section", the whole file is read
+        }
+    }
+    if (!header.empty()) {
+        FlushHeader();
+    }
+
+    for (const std::string& include : includes) {
+        if (!Scan(include)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IncludeGraph::Build(const std::string& fileName, const std::vector<std::pair<CELL_NAME, std::string> >& subckts,
+    const std::vector<std::string>& includes)
+{
+    _files.clear();
+    _indexes.clear();
+    const std::string path = Resolve("", fileName);
+    _indexes.emplace(path, 0);
+    _files.push_back({path, subckts});
+    for (const std::string& include : includes) {
+        if (!Scan(Resolve(path, include))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::vector<IncludeGraph::File>& IncludeGraph::GetFiles() const {
+    return _files;
+}
+
+std::string IncludeGraph::GetStubs(size_t index) const {
+    std::unordered_set<CELL_NAME, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> defined;
+    for (const auto& subckt : _files[index].subckts) {
+        defined.insert(subckt.first);
+    }
+
+    std::string stubs;
+    for (size_t i = 0; i < _files.size(); ++i) {
+        for (const auto& [name, ports] : _files[i].subckts) {
+            if (i != index && defined.insert(name).second) {
+                stubs += ".SUBCKT " + name + ports + "\n.ENDS\n";
+            }
+        }
+    }
+    return stubs;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../base/base.h"
+
+// Files reached through .INCLUDE and .LIB from a main file already read by Spice.
+// Only the .SUBCKT headers of the included files are read, so every file can be parsed alone against stubs of the others.
+class IncludeGraph {
+    public:
+        struct File {
+            std::string path; // canonical
+            std::vector<std::pair<CELL_NAME, std::string> > subckts; // name and port list
+        };
+    private:
+        std::vector<File> _files; // main file first
+        std::unordered_map<std::string, size_t> _indexes;
+    private:
+        static std::string Resolve(const std::string& includingFile, std::string token);
+        bool Scan(const std::string& path);
+    public:
+        // subckts and include arguments of the main file come from its parse, false if an included file can't be opened
+        bool Build(const std::string& fileName, const std::vector<std::pair<CELL_NAME, std::string> >& subckts,
+            const std::vector<std::string>& includes);
+        const std::vector<File>& GetFiles() const;
+        std::string GetStubs(size_t index) const; // port-only subckts of the other files
+};
@@ -0,0 +1,105 @@
+#include <sstream>
+#include <unordered_set>
+#include "incremental_loader.h"
+#include "library_cache.h"
+#include "../base/profile.h"
+
+READ_STATE IncrementalLoader::FullLoad(const std::string& fileName, const CELL_NAME& topCellName, Entry& entry) {
+    const READ_STATE readState = LibraryCache::ParseFile(fileName, topCellName, entry.netlist);
+    if (readState != READ_OK) {
+        entry.netlist = nullptr;
+        return readState;
+    }
+    entry.topCellName = topCellName;
+    _reparsedCells += entry.index.GetBlockNum();
+    return READ_OK;
+}
+
+READ_STATE IncrementalLoader::PatchLoad(SubcktIndex& index, Entry& entry) {
+    std::vector<CELL_NAME> changed, removed;
+    index.Diff(entry.index, changed, removed);
+    if (changed.empty() && removed.empty()) {
+        return READ_OK;
+    }
+
+    // changed blocks quote unchanged cells through stubs, Netlist::SpliceCells binds them to the cached cells
+    const std::unordered_set<CELL_NAME, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> changedSet(changed.begin(), changed.end());
+    std::ostringstream patch;
+    patch << index.GetOutsideText();
+    for (const auto& it : entry.netlist->_cells) {
+        if (changedSet.count(it.first) || it.first == MAIN_CELL) {
+            continue; // the main cell is parsed again from the outside text
+        }
+        patch << ".SUBCKT " << it.first;
+        for (const std::shared_ptr<Port>& port : it.second->GetPorts()) {
+            patch << " " << port->GetName();
+        }
+        patch << "\n.ENDS\n";
+    }
+    for (const CELL_NAME& name : changed) {
+        patch << index.ReadBlock(name) << "\n";
+    }
+
+    std::unique_ptr<Spice> spice = std::make_unique<Spice>();
+    READ_STATE readState = spice->ReadAndParseSpice(std::make_unique<std::istringstream>(patch.str()), "patch", entry.topCellName);
+    if (readState == READ_OK) {
+        readState = entry.netlist->SpliceCells(spice->GetNetlist(), changed, removed);
+    }
+    _reparsedCells += changed.size();
+    return readState;
+}
+
+READ_STATE IncrementalLoader::Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist) {
+    ScopedTimer timer("IncrementalLoad", fileName);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(_entriesMutex);
+        std::shared_ptr<Entry>& slot = _entries[fileName];
+        if (slot == nullptr) {
+            slot = std::make_shared<Entry>();
+        }
+        entry = slot;
+    }
+
+    std::lock_guard<std::mutex> lock(entry->mtx);
+    SubcktIndex index;
+    READ_STATE readState;
+    if ((readState = index.Build(fileName)) != READ_OK) {
+        return readState;
+    }
+    if (index.HasIncludes()) {
+        entry->netlist = nullptr;
+        return INCLUDE_FOUND;
+    }
+
+    const bool patched = entry->netlist != nullptr && entry->index.GetOutsideHash() == index.GetOutsideHash() &&
+        PatchLoad(index, *entry) == READ_OK;
+    entry->index = std::move(index);
+    if (!patched) {
+        // first load, edited top level lines or a patch that doesn't link
+        if ((readState = FullLoad(fileName, topCellName, *entry)) != READ_OK) {
+            return readState;
+        }
+    }
+
+    // the clone is taken under the entry lock, a concurrent Load of the same file may patch the cache right after
+    std::shared_ptr<Netlist> clone = entry->netlist->Clone();
+    if (clone == nullptr) {
+        return HIERARCHY_LOOP;
+    }
+    if (!topCellName.empty() && !MatchNoCase(clone->GetTopCell()->GetName(), topCellName)
+        && (readState = clone->SetTopCell(topCellName)) != READ_OK) {
+        return readState;
+    }
+    netlist = clone;
+    return READ_OK;
+}
+
+size_t IncrementalLoader::GetReparsedCells() const {
+    return _reparsedCells;
+}
+
+void IncrementalLoader::Clear() {
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    _entries.clear();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mutex>
+#include "spice.h"
+#include "subckt_index.h"
+
+// Keeps the last parse of every file in memory. On reload only the .SUBCKT blocks whose content hash
+// changed are parsed again, against port-only stubs of the unchanged cells, and spliced into the cache.
+// Load hands out a clone of the cached netlist, retargeted to the caller's top cell; the cache keeps its own top.
+class IncrementalLoader {
+    private:
+        struct Entry {
+            std::mutex mtx;
+            SubcktIndex index;
+            std::shared_ptr<Netlist> netlist; // only cloned by Load, never prepared, compared or retargeted
+            CELL_NAME topCellName;
+        };
+        std::mutex _entriesMutex;
+        std::unordered_map<std::string, std::shared_ptr<Entry> > _entries;
+        std::atomic<size_t> _reparsedCells{0};
+    private:
+        READ_STATE FullLoad(const std::string& fileName, const CELL_NAME& topCellName, Entry& entry);
+        READ_STATE PatchLoad(SubcktIndex& index, Entry& entry);
+    public:
+        static IncrementalLoader& GetInstance() {
+            static IncrementalLoader instance;
+            return instance;
+        }
+        // netlist is the caller's own clone; INCLUDE_FOUND for a file with .INCLUDE/.LIB, LibraryCache loads those
+        READ_STATE Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist);
+        size_t GetReparsedCells() const; // cells parsed by the last loads, for reports
+        void Clear();
+};
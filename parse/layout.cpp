@@ -1 +1,253 @@
-#include "layout.h"
\ No newline at end of file
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include "layout.h"
+#include "compressed_input.h"
+
+uint64_t Layout::HashName(const std::string& name) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(c)))) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+void Layout::Orient(uint8_t orientation, double& x, double& y) {
+    if (orientation & 4) {
+        y = -y;
+    }
+    for (uint8_t rotation = orientation & 3; rotation != 0; --rotation) {
+        const double oldX = x;
+        x = -y;
+        y = oldX;
+    }
+}
+
+uint8_t Layout::ComposeOrientation(uint8_t outer, uint8_t inner) {
+    // the orientation that maps both unit vectors the same way as inner followed by outer
+    double x1 = 1.0, y1 = 0.0, x2 = 0.0, y2 = 1.0;
+    for (const uint8_t orientation : {inner, outer}) {
+        Orient(orientation, x1, y1);
+        Orient(orientation, x2, y2);
+    }
+    for (uint8_t orientation = 0; orientation < 8; ++orientation) {
+        double u1 = 1.0, v1 = 0.0, u2 = 0.0, v2 = 1.0;
+        Orient(orientation, u1, v1);
+        Orient(orientation, u2, v2);
+        if (u1 == x1 && v1 == y1 && u2 == x2 && v2 == y2) {
+            return orientation;
+        }
+    }
+    return 0;
+}
+
+uint8_t Layout::ParseOrientation(const std::vector<std::string>& numbers) {
+    if (numbers.size() >= 6) {
+        // a b c d of the matrix that maps (x, y) to (a x + b y, c x + d y)
+        double entries[4];
+        for (size_t i = 0; i < 4; ++i) {
+            entries[i] = std::round(std::strtod(numbers[2 + i].c_str(), nullptr));
+        }
+        for (uint8_t orientation = 0; orientation < 8; ++orientation) {
+            double x1 = 1.0, y1 = 0.0, x2 = 0.0, y2 = 1.0;
+            Orient(orientation, x1, y1);
+            Orient(orientation, x2, y2);
+            if (x1 == entries[0] && y1 == entries[2] && x2 == entries[1] && y2 == entries[3]) {
+                return orientation;
+            }
+        }
+        return 0;
+    }
+    const long angle = numbers.size() > 2 ? std::lround(std::strtod(numbers[2].c_str(), nullptr) / 90.0) : 0;
+    const bool mirror = numbers.size() > 3 && std::strtod(numbers[3].c_str(), nullptr) != 0.0;
+    return static_cast<uint8_t>((mirror ? 4 : 0) | (((angle % 4) + 4) % 4));
+}
+
+int32_t Layout::GetCellIndex(const CELL_NAME& name) {
+    const auto& it = _cellIndexes.find(name);
+    if (it != _cellIndexes.end()) {
+        return it->second;
+    }
+    const int32_t index = static_cast<int32_t>(_cells.size());
+    _cells.emplace_back();
+    _cellIndexes.emplace(name, index);
+    return index;
+}
+
+void Layout::ReadLine(int32_t cellIndex, const std::vector<std::string>& tokens) {
+    bool placed = false;
+    double x = 0.0, y = 0.0;
+    uint8_t orientation = 0;
+    std::string master;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        const std::string& token = tokens[i];
+        if (StartWithNoCase(token, "$X=")) {
+            x = std::strtod(token.c_str() + 3, nullptr);
+            placed = true;
+        } else if (StartWithNoCase(token, "$Y=")) {
+            y = std::strtod(token.c_str() + 3, nullptr);
+            placed = true;
+        } else if (StartWithNoCase(token, "$T=")) {
+            // $T=x y followed by the orientation numbers
+            std::vector<std::string> numbers = {token.substr(3)};
+            while (i + 1 < tokens.size() && tokens[i + 1].find('=') == std::string::npos) {
+                numbers.emplace_back(tokens[++i]);
+            }
+            if (numbers.size() >= 2) {
+                x = std::strtod(numbers[0].c_str(), nullptr);
+                y = std::strtod(numbers[1].c_str(), nullptr);
+                placed = true;
+            }
+            orientation = ParseOrientation(numbers);
+        } else if (token.find('=') == std::string::npos && token[0] != '$') {
+            master = token; // the last node token of an X line is the quoted cell
+        }
+    }
+    if (!placed) {
+        return;
+    }
+
+    const bool isQuote = std::toupper(static_cast<unsigned char>(tokens[0][0])) == 'X';
+    const int32_t masterIndex = isQuote && !master.empty() ? GetCellIndex(master) : -1;
+
+    CellPlacement& cell = _cells[cellIndex];
+    cell.nameHashes.emplace_back(HashName(tokens[0]));
+    cell.x.emplace_back(static_cast<float>(x));
+    cell.y.emplace_back(static_cast<float>(y));
+    cell.orientations.emplace_back(orientation);
+    cell.masters.emplace_back(masterIndex);
+}
+
+void Layout::SortColumns() {
+    for (CellPlacement& cell : _cells) {
+        std::vector<size_t> order(cell.nameHashes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&cell](size_t a, size_t b) {
+            return cell.nameHashes[a] < cell.nameHashes[b];
+        });
+        auto Permute = [&order](auto& column) {
+            std::remove_reference_t<decltype(column)> sorted;
+            sorted.reserve(order.size());
+            for (size_t index : order) {
+                sorted.emplace_back(column[index]);
+            }
+            column.swap(sorted);
+        };
+        Permute(cell.nameHashes);
+        Permute(cell.x);
+        Permute(cell.y);
+        Permute(cell.orientations);
+        Permute(cell.masters);
+    }
+}
+
+bool Layout::Read(const std::string& fileName) {
+    const std::unique_ptr<std::istream> input = OpenInput(fileName);
+    if (input == nullptr) {
+        return false;
+    }
+    std::istream& file = *input;
+
+    int32_t nowCell = GetCellIndex(""); // top level lines
+    std::vector<std::string> tokens;
+    auto Flush = [this, &nowCell, &tokens]() {
+        if (!tokens.empty()) {
+            const char type = static_cast<char>(std::toupper(static_cast<unsigned char>(tokens[0][0])));
+            if (type == 'M' || type == 'X') {
+                ReadLine(nowCell, tokens);
+            }
+        }
+        tokens.clear();
+    };
+
+    std::string line, token;
+    while (std::getline(file, line)) {
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '*') {
+            continue;
+        }
+        if (line[first] != '+') {
+            Flush();
+        }
+        std::istringstream lineStream(line[first] == '+' ? line.substr(first + 1) : line);
+        while (lineStream >> token) {
+            tokens.emplace_back(token);
+        }
+        if (!tokens.empty() && StartWithNoCase(tokens[0], ".SUBCKT")) {
+            nowCell = tokens.size() > 1 ? GetCellIndex(tokens[1]) : nowCell;
+            tokens.clear();
+        } else if (!tokens.empty() && StartWithNoCase(tokens[0], ".ENDS")) {
+            nowCell = GetCellIndex("");
+            tokens.clear();
+        }
+    }
+    Flush();
+    if (file.bad()) {
+        return false; // placements of a cut off file would mislead the symmetry breaking
+    }
+
+    SortColumns();
+    for (CellPlacement& cell : _cells) {
+        cell.nameHashes.shrink_to_fit();
+        cell.x.shrink_to_fit();
+        cell.y.shrink_to_fit();
+        cell.orientations.shrink_to_fit();
+        cell.masters.shrink_to_fit();
+    }
+    return true;
+}
+
+bool Layout::FindOne(int32_t cellIndex, const std::string& name, size_t& row) const {
+    const std::vector<uint64_t>& hashes = _cells[cellIndex].nameHashes;
+    const auto it = std::lower_bound(hashes.begin(), hashes.end(), HashName(name));
+    if (it == hashes.end() || *it != HashName(name)) {
+        return false;
+    }
+    row = it - hashes.begin();
+    return true;
+}
+
+bool Layout::FindPlacement(const CELL_NAME& cellName, const std::string& path, Placement& placement) const {
+    const auto& it = _cellIndexes.find(cellName);
+    if (it == _cellIndexes.end()) {
+        return false;
+    }
+
+    // placement holds the origin and orientation of the instance walked into so far
+    int32_t cellIndex = it->second;
+    placement = {0.0, 0.0, 0};
+    std::stringstream pathStream(path);
+    std::string name;
+    while (std::getline(pathStream, name, '/')) {
+        size_t row;
+        if (cellIndex < 0 || !FindOne(cellIndex, name, row)) {
+            return false;
+        }
+        const CellPlacement& cell = _cells[cellIndex];
+        double x = cell.x[row], y = cell.y[row];
+        Orient(placement.orientation, x, y);
+        placement.x += x;
+        placement.y += y;
+        placement.orientation = ComposeOrientation(placement.orientation, cell.orientations[row]);
+        cellIndex = cell.masters[row];
+    }
+    return true;
+}
+
+size_t Layout::GetPlacementNum() const {
+    size_t placementNum = 0;
+    for (const CellPlacement& cell : _cells) {
+        placementNum += cell.nameHashes.size();
+    }
+    return placementNum;
+}
+
+uint64_t Layout::GetMemorySize() const {
+    uint64_t bytes = sizeof(Layout) + _cells.capacity() * sizeof(CellPlacement);
+    for (const CellPlacement& cell : _cells) {
+        bytes += cell.nameHashes.capacity() * sizeof(uint64_t) + cell.x.capacity() * sizeof(float) + cell.y.capacity() * sizeof(float)
+            + cell.orientations.capacity() * sizeof(uint8_t) + cell.masters.capacity() * sizeof(int32_t);
+    }
+    return bytes;
+}
@@ -1,7 +1,38 @@
-#pragma once
-
-#include "../netlist/netlist.h"
-
-class Layout {
-
-};
\ No newline at end of file
+#pragma once
+
+#include "../netlist/netlist.h"
+
+// Placement annotations ($X= $Y= $T=) of M and X lines, read in a separate pass over the spice file.
+// Columns are sorted by the hash of the device name, about 21 bytes per placed device or instance.
+// An orientation is a mirror about the x axis (bit 2) followed by a rotation of 90 degrees times bits 0-1.
+class Layout {
+    public:
+        struct Placement {
+            double x, y;
+            uint8_t orientation; // composed along the path, 0 is none
+        };
+    private:
+        struct CellPlacement {
+            std::vector<uint64_t> nameHashes;
+            std::vector<float> x, y;
+            std::vector<uint8_t> orientations;
+            std::vector<int32_t> masters; // cell index of an instance, -1 for devices
+        };
+        std::vector<CellPlacement> _cells;
+        std::unordered_map<CELL_NAME, int32_t, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _cellIndexes;
+    private:
+        static uint64_t HashName(const std::string& name);
+        static void Orient(uint8_t orientation, double& x, double& y);
+        static uint8_t ComposeOrientation(uint8_t outer, uint8_t inner);
+        static uint8_t ParseOrientation(const std::vector<std::string>& numbers); // after x y: angle [mirror] or a 2x2 matrix
+        int32_t GetCellIndex(const CELL_NAME& name);
+        void ReadLine(int32_t cellIndex, const std::vector<std::string>& tokens);
+        void SortColumns();
+        bool FindOne(int32_t cellIndex, const std::string& name, size_t& row) const;
+    public:
+        bool Read(const std::string& fileName);
+        // path is a flattened device name such as "X1/X2/M3", positions inside an instance are oriented and offset by it
+        bool FindPlacement(const CELL_NAME& cellName, const std::string& path, Placement& placement) const;
+        size_t GetPlacementNum() const;
+        uint64_t GetMemorySize() const;
+};
@@ -0,0 +1,117 @@
+#include <unordered_set>
+#include "library_cache.h"
+#include "compressed_input.h"
+#include "../base/thread_pool.h"
+#include "../base/profile.h"
+
+READ_STATE LibraryCache::ParseFile(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist) {
+    // a compressed file streams from the decompressor thread, nothing goes to disk
+    std::unique_ptr<Spice> spice = std::make_unique<Spice>();
+    const READ_STATE readState = spice->ReadAndParseSpice(OpenInput(fileName), fileName, topCellName);
+    netlist = spice->GetNetlist();
+    return readState;
+}
+
+LibraryCache::PARSE_RESULT LibraryCache::ParseAlone(const std::string& path, const std::string& stubs, const CELL_NAME& topCellName) {
+    ScopedTimer timer("ParseAlone", path);
+    // Spice skips the include lines, the subckts of the other files are declared by the stubs
+    std::unique_ptr<Spice> spice = std::make_unique<Spice>();
+    const READ_STATE readState = spice->ReadAndParseSpice(OpenInput(path), path, topCellName, stubs);
+    return {readState, spice->GetNetlist()}; // the netlist of a failed parse holds the error
+}
+
+std::shared_future<LibraryCache::PARSE_RESULT> LibraryCache::GetLibrary(const IncludeGraph& graph, size_t index) {
+    const std::string& path = graph.GetFiles()[index].path;
+    std::error_code error;
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(path, error);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto& it = _entries.find(path);
+    if (it != _entries.end() && it->second.mtime == mtime) {
+        ++_hits;
+        return it->second.result;
+    }
+    const std::string stubs = graph.GetStubs(index);
+    std::shared_future<PARSE_RESULT> result = ThreadPool::GetInstance().Submit([path, stubs]() {
+        return ParseAlone(path, stubs, "");
+    }).share();
+    _entries[path] = {mtime, result};
+    return result;
+}
+
+READ_STATE LibraryCache::Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist,
+    const std::function<bool(const IncludeGraph&)>& onGraph)
+{
+    ScopedTimer timer("LibraryLoad", fileName);
+    // the main file is read once, streamed like any other file; its includes are known at the end of it
+    std::unique_ptr<Spice> spice = std::make_unique<Spice>();
+    spice->SetDeferIncludes(true);
+    READ_STATE readState = spice->ReadAndParseSpice(OpenInput(fileName), fileName, topCellName);
+    netlist = spice->GetNetlist();
+    if (readState != INCLUDE_FOUND) {
+        return readState;
+    }
+
+    std::vector<std::pair<CELL_NAME, std::string> > subckts;
+    for (const auto& [name, cell] : netlist->_cells) {
+        if (name == MAIN_CELL) {
+            continue;
+        }
+        std::string ports;
+        for (const std::shared_ptr<Port>& port : cell->GetPorts()) {
+            ports += " " + port->GetName();
+        }
+        subckts.emplace_back(name, ports);
+    }
+    IncludeGraph graph;
+    if (!graph.Build(fileName, subckts, spice->GetIncludes()) || (onGraph != nullptr && !onGraph(graph))) {
+        return NO_FILE;
+    }
+
+    // libraries go to the pool, the quotes of the main file are bound meanwhile against their stubs
+    const std::vector<IncludeGraph::File>& files = graph.GetFiles();
+    std::vector<std::shared_future<PARSE_RESULT> > libraries;
+    for (size_t i = 1; i < files.size(); ++i) {
+        libraries.emplace_back(GetLibrary(graph, i));
+    }
+    if ((readState = spice->Link(graph.GetStubs(0), topCellName)) != READ_OK) {
+        return readState;
+    }
+
+    // the first definition wins, as in a single file
+    std::unordered_set<CELL_NAME, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> defined;
+    for (const auto& subckt : files.front().subckts) {
+        defined.insert(subckt.first);
+    }
+    for (size_t i = 1; i < files.size(); ++i) {
+        const PARSE_RESULT& library = ThreadPool::GetInstance().Wait(libraries[i - 1]);
+        if (library.first != READ_OK) {
+            netlist = library.second; // for OutputError
+            return library.first;
+        }
+        const std::shared_ptr<Netlist> clone = library.second->Clone();
+        if (clone == nullptr) {
+            return HIERARCHY_LOOP;
+        }
+
+        std::vector<CELL_NAME> cells;
+        for (const auto& subckt : files[i].subckts) {
+            if (defined.insert(subckt.first).second) {
+                cells.emplace_back(subckt.first);
+            }
+        }
+        if ((readState = netlist->SpliceCells(clone, cells, {})) != READ_OK) {
+            return readState;
+        }
+    }
+    return READ_OK;
+}
+
+size_t LibraryCache::GetHits() const {
+    return _hits;
+}
+
+void LibraryCache::Clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
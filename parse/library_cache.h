@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include "spice.h"
+#include "include_graph.h"
+
+// Parses a main file and everything it reaches through .INCLUDE/.LIB. Every file is parsed alone, with stubs
+// of the subckts of the other files, concurrently on ThreadPool. Included files are cached by path and mtime,
+// so libraries shared by both netlists or by several runs are parsed once; their cells are spliced into the
+// netlist of the main file.
+class LibraryCache {
+    private:
+        typedef std::pair<READ_STATE, std::shared_ptr<Netlist> > PARSE_RESULT;
+        struct Entry {
+            std::filesystem::file_time_type mtime;
+            std::shared_future<PARSE_RESULT> result; // never compared, callers splice clones
+        };
+        std::mutex _mutex;
+        std::unordered_map<std::string, Entry> _entries;
+        std::atomic<size_t> _hits{0};
+    private:
+        static PARSE_RESULT ParseAlone(const std::string& path, const std::string& stubs, const CELL_NAME& topCellName);
+        std::shared_future<PARSE_RESULT> GetLibrary(const IncludeGraph& graph, size_t index);
+    public:
+        static LibraryCache& GetInstance() {
+            static LibraryCache instance;
+            return instance;
+        }
+        static READ_STATE ParseFile(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist); // plain, .gz or .zst
+        // onGraph sees the included files before they are parsed, false stops the load with NO_FILE
+        READ_STATE Load(const std::string& fileName, const CELL_NAME& topCellName, std::shared_ptr<Netlist>& netlist,
+            const std::function<bool(const IncludeGraph&)>& onGraph = nullptr);
+        size_t GetHits() const;
+        void Clear();
+};
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <sstream>
+#include "spice.h"
+#include "../base/profile.h"
+
+Spice::Spice() : _netlist(std::make_shared<Netlist>()), _lineNum(0), _tokenIndex(0) {}
+
+std::shared_ptr<Netlist> Spice::GetNetlist() const {
+    return _netlist;
+}
+
+std::shared_ptr<Cell> Spice::FindCell(const CELL_NAME& name) const {
+    return _netlist->FindCell(name);
+}
+
+bool Spice::EndFile() const {
+    return _line.empty();
+}
+
+void Spice::OpenStream(std::unique_ptr<std::istream> input, const std::string& name) {
+    _nowFile = std::move(input);
+    _fileName = name;
+    _lineNum = 0;
+    _line.clear();
+    _lineTokens.clear();
+    _tokenIndex = 0;
+}
+
+void Spice::CloseFile() {
+    _nowFile = nullptr;
+}
+
+void Spice::SetDeferIncludes(bool defer) {
+    _deferIncludes = defer;
+}
+
+const std::vector<std::string>& Spice::GetIncludes() const {
+    return _includes;
+}
+
+bool Spice::SkipToNextLine() {
+    if (!std::getline(*_nowFile, _line)) {
+        _line.clear();
+        return false;
+    }
+    ++_lineNum;
+    if (!_line.empty() && _line.back() == '\r') {
+        _line.pop_back();
+    }
+    return true;
+}
+
+void Spice::SkipToNextNotEmptyLine() {
+    while (SkipToNextLine()) {
+        const size_t first = _line.find_first_not_of(" \t");
+        if (first != std::string::npos && _line[first] != '*') {
+            return;
+        }
+    }
+}
+
+void Spice::SkipToFileEnds() {
+    while (SkipToNextLine()) {}
+}
+
+void Spice::GetLineTokens() {
+    // one statement: the current line and every "+" line after it, _line ends on the next statement
+    auto AddTokens = [this](const std::string& text) {
+        std::string token;
+        for (size_t i = 0; i <= text.size(); ++i) {
+            const char c = i < text.size() ? text[i] : ' ';
+            if (c == ' ' || c == '\t' || c == '\'' || c == '"') {
+                if (!token.empty()) {
+                    _lineTokens.emplace_back(std::move(token));
+                    token.clear();
+                }
+            } else {
+                token += c;
+            }
+        }
+    };
+
+    _lineTokens.clear();
+    _tokenIndex = 0;
+    AddTokens(_line);
+    while (SkipToNextLine()) {
+        const size_t first = _line.find_first_not_of(" \t");
+        if (first == std::string::npos || _line[first] == '*') {
+            continue;
+        }
+        if (_line[first] != '+') {
+            break;
+        }
+        AddTokens(_line.substr(first + 1));
+    }
+
+    // "W = 1u" is the same as "W=1u"
+    for (size_t i = 0; i < _lineTokens.size(); ++i) {
+        while (i + 1 < _lineTokens.size() && (_lineTokens[i].back() == '=' || _lineTokens[i + 1][0] == '=')) {
+            _lineTokens[i] += _lineTokens[i + 1];
+            _lineTokens.erase(_lineTokens.begin() + i + 1);
+        }
+    }
+}
+
+bool Spice::SkipToNextToken() {
+    if (_tokenIndex >= _lineTokens.size()) {
+        _nextToken.clear();
+        return false;
+    }
+    _nextToken = _lineTokens[_tokenIndex++];
+    return true;
+}
+
+void Spice::SkipToNextLineToken() {
+    GetLineTokens();
+    SkipToNextToken();
+}
+
+READ_STATE Spice::ReadSubckt() {
+    if (!SkipToNextToken()) {
+        return SUBCKT_NO_NAME;
+    }
+    if (_nowCell != _mainCell) {
+        return SUBCKT_NO_ENDS; // nested subckt
+    }
+    const std::shared_ptr<Cell> cell = _netlist->DefineCell(_nextToken);
+    if (cell == nullptr) {
+        _netlist->_error.errorInformation = "subckt " + _nextToken + " is redefined.";
+        return SUBCKT_REDEFINE;
+    }
+    _nowCell = cell;
+
+    while (SkipToNextToken()) {
+        const size_t equal = _nextToken.find('=');
+        if (equal != std::string::npos) {
+            cell->SetParameterValue(_nextToken.substr(0, equal), _nextToken.substr(equal + 1));
+            continue;
+        }
+        if (MatchNoCase(_nextToken, "PARAMS:")) {
+            continue;
+        }
+        if (cell->_portsMap.count(_nextToken)) {
+            _netlist->_error.errorInformation = "port " + _nextToken + " of subckt " + cell->GetName() + " is redefined.";
+            return SUBCKT_PORT_REDEFINE;
+        }
+        cell->_portsMap[_nextToken] = static_cast<PORT_INDEX>(cell->GetPorts().size());
+        cell->GetPorts().emplace_back(std::make_shared<Port>(_nextToken));
+    }
+    // unused ports still get a net, so every port is bound
+    for (const auto& it : cell->_portsMap) {
+        cell->DefineNet(it.first);
+    }
+    return READ_OK;
+}
+
+READ_STATE Spice::ReadM() {
+    // Mname drain gate source bulk model [W= L= ...] [$X= $Y= ...]
+    const DEVICE_NAME name = _nextToken;
+    std::vector<std::string> nodes;
+    while (SkipToNextToken() && _nextToken.find('=') == std::string::npos && _nextToken[0] != '$') {
+        nodes.emplace_back(_nextToken);
+    }
+    if (nodes.size() < 5) {
+        _netlist->_error.errorInformation = "mosfet " + name + " needs 4 nets and a model.";
+        return READ_MOSFET_ERROR;
+    }
+
+    const std::shared_ptr<Mosfet> mosfet = std::make_shared<Mosfet>(name);
+    mosfet->SetCell(_nowCell);
+    mosfet->SetNetlist(_netlist);
+    mosfet->SetModel(nodes[4]);
+    if (!_nowCell->AddDevice(mosfet)) {
+        _netlist->_error.errorInformation = "device " + name + " of subckt " + _nowCell->GetName() + " is redefined.";
+        return SUBCKT_DEVICE_REDEFINE;
+    }
+
+    const std::vector<PIN_MAGIC>& pinMagics = pinMagicTable[DEVICE_TYPE_MOSFET];
+    for (size_t i = 0; i < 4; ++i) {
+        mosfet->AddConnectNet(_nowCell->DefineNet(nodes[i]), pinMagics[i]);
+    }
+
+    for (bool next = !_nextToken.empty(); next; next = SkipToNextToken()) {
+        const size_t equal = _nextToken.find('=');
+        if (equal == std::string::npos || _nextToken[0] == '$') {
+            continue;
+        }
+        mosfet->SetPropertyValue(_nextToken.substr(0, equal), _nextToken.substr(equal + 1),
+            _nowCell->GetParameters(), _netlist->GetGlobalParameters());
+    }
+    return READ_OK;
+}
+
+READ_STATE Spice::ReadX() {
+    // Xname net... cell [name=value ...] [$T= ...], the cell is found among the tokens by Netlist::QuotePointToCell
+    const std::shared_ptr<Quote> quote = std::make_shared<Quote>(_nextToken);
+    quote->SetCell(_nowCell);
+    quote->SetNetlist(_netlist);
+    while (SkipToNextToken() && _nextToken.find('=') == std::string::npos && _nextToken[0] != '$') {
+        quote->_tokens.emplace_back(_nextToken);
+    }
+    if (quote->_tokens.empty()) {
+        _netlist->_error.errorInformation = quote->GetName() + " quotes no cell.";
+        return QUOTE_CANT_FIND_CELL;
+    }
+    quote->SetModel(quote->_tokens.back());
+    if (!_nowCell->AddDevice(quote)) {
+        _netlist->_error.errorInformation = "device " + quote->GetName() + " of subckt " + _nowCell->GetName() + " is redefined.";
+        return SUBCKT_DEVICE_REDEFINE;
+    }
+    _nowCell->GetQuotes().push_front(quote);
+
+    for (bool next = !_nextToken.empty(); next; next = SkipToNextToken()) {
+        const size_t equal = _nextToken.find('=');
+        if (equal == std::string::npos || _nextToken[0] == '$') {
+            continue;
+        }
+        quote->SetPropertyValue(_nextToken.substr(0, equal), _nextToken.substr(equal + 1),
+            _nowCell->GetParameters(), _netlist->GetGlobalParameters());
+    }
+    return READ_OK;
+}
+
+READ_STATE Spice::ReadSpice() {
+    READ_STATE readState = READ_OK;
+    SkipToNextNotEmptyLine();
+    while (!EndFile() && readState == READ_OK) {
+        SkipToNextLineToken();
+        if (_nextToken.empty()) {
+            continue;
+        }
+
+        const char type = static_cast<char>(std::toupper(static_cast<unsigned char>(_nextToken[0])));
+        if (type == '.') {
+            if (MatchNoCase(_nextToken, ".SUBCKT")) {
+                readState = ReadSubckt();
+            } else if (MatchNoCase(_nextToken, ".ENDS")) {
+                if (_nowCell == _mainCell) {
+                    readState = ENDS_NO_MATCH_SUBCKT;
+                }
+                _nowCell = _mainCell;
+            } else if (MatchNoCase(_nextToken, ".GLOBAL")) {
+                while (SkipToNextToken()) {
+                    _netlist->AddGlobalNet(_nextToken);
+                }
+            } else if (MatchNoCase(_nextToken, ".PARAM")) {
+                while (SkipToNextToken()) {
+                    const size_t equal = _nextToken.find('=');
+                    if (equal == std::string::npos) {
+                        continue;
+                    }
+                    if (_nowCell == _mainCell) {
+                        _netlist->GetGlobalParameters()[_nextToken.substr(0, equal)] = Expression().SolveExpression(
+                            _nextToken.substr(equal + 1), _mainCell->GetParameters(), _netlist->GetGlobalParameters());
+                    } else {
+                        _nowCell->SetParameterValue(_nextToken.substr(0, equal), _nextToken.substr(equal + 1));
+                    }
+                }
+            } else if (MatchNoCase(_nextToken, ".END")) {
+                SkipToFileEnds();
+            } else if (MatchNoCase(_nextToken, ".INCLUDE") || MatchNoCase(_nextToken, ".INC") || MatchNoCase(_nextToken, ".LIB")) {
+                // ".LIB section" only opens a section of a library file, ".LIB file section" includes one
+                const size_t arguments = _lineTokens.size() - _tokenIndex;
+                if (arguments >= (MatchNoCase(_nextToken, ".LIB") ? 2 : 1)) {
+                    _includes.emplace_back(_lineTokens[_tokenIndex]);
+                }
+            }
+            // .INCLUDE/.LIB are followed by LibraryCache, other controls don't change the netlist
+        } else if (type == 'M') {
+            readState = ReadM();
+        } else if (type == 'X') {
+            readState = ReadX();
+        }
+        // R, C, D, Q and L are not compared yet
+    }
+    if (readState != READ_OK) {
+        _netlist->_error.errorLine = static_cast<int32_t>(_lineNum);
+        return readState;
+    }
+    return _nowCell == _mainCell ? READ_OK : SUBCKT_NO_ENDS;
+}
+
+READ_STATE Spice::OpenReadAndParseSpice(const std::string& fileName, const CELL_NAME& topCellName) {
+    std::unique_ptr<std::fstream> file = std::make_unique<std::fstream>(fileName, std::ios::in);
+    if (!file->is_open()) {
+        return NO_FILE;
+    }
+    return ReadAndParseSpice(std::move(file), fileName, topCellName);
+}
+
+READ_STATE Spice::ReadAndParseSpice(std::unique_ptr<std::istream> input, const std::string& fileName, const CELL_NAME& topCellName,
+    const std::string& stubs)
+{
+    ScopedTimer timer("Parse", fileName);
+    if (input == nullptr) {
+        return NO_FILE;
+    }
+    _mainCell = _netlist->DefineCell(MAIN_CELL);
+    _nowCell = _mainCell;
+    READ_STATE readState = READ_OK;
+    if (!stubs.empty()) {
+        OpenStream(std::make_unique<std::istringstream>(stubs), fileName);
+        readState = ReadSpice();
+    }
+    if (readState == READ_OK) {
+        OpenStream(std::move(input), fileName); // line numbers of errors count from the first line of the file
+        readState = ReadSpice();
+        if (readState == READ_OK && _nowFile->bad()) {
+            readState = INPUT_CORRUPT; // a partial netlist must not compare
+        }
+    }
+    CloseFile();
+    if (readState != READ_OK) {
+        return readState;
+    }
+    if (_deferIncludes && !_includes.empty()) {
+        return INCLUDE_FOUND;
+    }
+    return LinkCells(topCellName);
+}
+
+READ_STATE Spice::Link(const std::string& stubs, const CELL_NAME& topCellName) {
+    if (!stubs.empty()) {
+        OpenStream(std::make_unique<std::istringstream>(stubs), _fileName);
+        const READ_STATE readState = ReadSpice();
+        CloseFile();
+        if (readState != READ_OK) {
+            return readState;
+        }
+    }
+    return LinkCells(topCellName);
+}
+
+READ_STATE Spice::LinkCells(const CELL_NAME& topCellName) {
+    // quotes may name cells defined later in the file
+    READ_STATE readState;
+    for (const auto& it : _netlist->_cells) {
+        if ((readState = _netlist->QuotePointToCell(it.second)) != READ_OK) {
+            return readState;
+        }
+    }
+
+    const std::shared_ptr<Cell> topCell = topCellName.empty() ? nullptr : FindCell(topCellName);
+    _netlist->_topCell = topCell != nullptr ? topCell : _mainCell;
+    return _netlist->BuildHierarchyStructure() ? READ_OK : HIERARCHY_LOOP;
+}
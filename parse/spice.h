@@ -3,12 +3,14 @@
 #include <fstream>
 #include "../netlist/netlist.h"
 
+constexpr const char* MAIN_CELL = "__MAIN__"; // lines outside any subckt, the top cell if no other is named
+
 class Netlist;
 class Spice {
 private:
     std::shared_ptr<Netlist> _netlist;
 
-    std::unique_ptr<std::fstream> _nowFile;
+    std::unique_ptr<std::istream> _nowFile;
     std::string _fileName;
     std::shared_ptr<Cell> _mainCell;
     std::shared_ptr<Cell> _nowCell;
@@ -17,10 +19,12 @@ private:
     std::string _line;
     std::vector<std::string> _lineTokens;
     size_t _tokenIndex;
+    bool _deferIncludes{false};
+    std::vector<std::string> _includes; // file argument of every .INCLUDE/.LIB, in order
 private:
     /* copy code begin */
     bool EndFile() const;
-    bool OpenFile(const std::string& name);
+    void OpenStream(std::unique_ptr<std::istream> input, const std::string& name);
     void CloseFile();
 
     READ_STATE ReadSpice();
@@ -45,8 +49,16 @@ private:
     /* copy code end */
 
     std::shared_ptr<Cell> FindCell(const CELL_NAME& name) const;
+    READ_STATE LinkCells(const CELL_NAME& topCellName); // bind quotes, pick the top cell, build the hierarchy
 public:
     Spice();
     std::shared_ptr<Netlist> GetNetlist() const;
+    // a file with .INCLUDE/.LIB is read to the end, then the parse returns INCLUDE_FOUND and Link finishes it
+    void SetDeferIncludes(bool defer);
+    const std::vector<std::string>& GetIncludes() const;
     READ_STATE OpenReadAndParseSpice(const std::string& fileName, const CELL_NAME& topCellName); // copy code
+    // input opened by the caller, e.g. a decompressed file; stubs are parsed first, ahead of the subckts they declare
+    READ_STATE ReadAndParseSpice(std::unique_ptr<std::istream> input, const std::string& fileName, const CELL_NAME& topCellName,
+        const std::string& stubs = "");
+    READ_STATE Link(const std::string& stubs, const CELL_NAME& topCellName); // after INCLUDE_FOUND, stubs of the included subckts
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <fstream>
+#include <sstream>
+#include "subckt_index.h"
+#include "compressed_input.h"
+
+namespace {
+    constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    uint64_t HashLine(uint64_t hash, const std::string& line) {
+        for (const char c : line) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+        }
+        return (hash ^ static_cast<uint8_t>('\n')) * FNV_PRIME;
+    }
+}
+
+READ_STATE SubcktIndex::Build(const std::string& fileName) {
+    const std::unique_ptr<std::istream> input = OpenInput(fileName);
+    if (input == nullptr) {
+        return NO_FILE;
+    }
+    std::istream& file = *input;
+    _fileName = fileName;
+    _blocks.clear();
+    _outsideHash = FNV_OFFSET;
+    _outsideText.clear();
+    _hasIncludes = false;
+
+    std::string line;
+    CELL_NAME nowCell;
+    Block block{FNV_OFFSET, 0, 0};
+    std::streamoff lineBegin = 0; // offsets in the decompressed text, a compressed stream can't tell
+    while (std::getline(file, line)) {
+        const std::streamoff lineEnd = lineBegin + static_cast<std::streamoff>(line.size()) + 1;
+        const size_t first = line.find_first_not_of(" \t");
+        const size_t last = line.find_last_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '*') {
+            lineBegin = lineEnd;
+            continue;
+        }
+        const std::string trimmed = line.substr(first, last - first + 1);
+
+        if (nowCell.empty() && StartWithNoCase(trimmed, ".SUBCKT")) {
+            std::istringstream tokens(trimmed);
+            std::string keyword;
+            tokens >> keyword >> nowCell;
+            block = {HashLine(FNV_OFFSET, trimmed), lineBegin, lineEnd};
+        } else if (!nowCell.empty()) {
+            block.hash = HashLine(block.hash, trimmed);
+            block.end = lineEnd;
+            if (StartWithNoCase(trimmed, ".ENDS")) {
+                _blocks[nowCell] = block;
+                nowCell.clear();
+            }
+        } else {
+            _outsideHash = HashLine(_outsideHash, trimmed);
+            _outsideText += trimmed + "\n";
+            std::istringstream tokens(trimmed);
+            std::string keyword, file, section;
+            tokens >> keyword >> file >> section;
+            _hasIncludes = _hasIncludes || ((MatchNoCase(keyword, ".INCLUDE") || MatchNoCase(keyword, ".INC")) && !file.empty())
+                || (MatchNoCase(keyword, ".LIB") && !section.empty());
+        }
+        lineBegin = lineEnd;
+    }
+    return file.bad() ? INPUT_CORRUPT : READ_OK;
+}
+
+void SubcktIndex::Diff(const SubcktIndex& old, std::vector<CELL_NAME>& changed, std::vector<CELL_NAME>& removed) const {
+    for (const auto& it : _blocks) {
+        const auto& oldIt = old._blocks.find(it.first);
+        if (oldIt == old._blocks.end() || oldIt->second.hash != it.second.hash) {
+            changed.emplace_back(it.first);
+        }
+    }
+    for (const auto& it : old._blocks) {
+        if (!_blocks.count(it.first)) {
+            removed.emplace_back(it.first);
+        }
+    }
+}
+
+std::string SubcktIndex::ReadBlock(const CELL_NAME& name) const {
+    const auto& it = _blocks.find(name);
+    if (it == _blocks.end()) {
+        return "";
+    }
+    const std::unique_ptr<std::istream> input = OpenInput(_fileName);
+    if (input == nullptr) {
+        return "";
+    }
+    std::string text(it->second.end - it->second.begin, '\0');
+    if (!input->seekg(it->second.begin)) {
+        input->clear();
+        input->ignore(it->second.begin); // compressed, decompress up to the block
+    }
+    input->read(text.data(), static_cast<std::streamsize>(text.size()));
+    text.resize(input->gcount());
+    return text;
+}
+
+uint64_t SubcktIndex::GetOutsideHash() const {
+    return _outsideHash;
+}
+
+const std::string& SubcktIndex::GetOutsideText() const {
+    return _outsideText;
+}
+
+size_t SubcktIndex::GetBlockNum() const {
+    return _blocks.size();
+}
+
+bool SubcktIndex::HasIncludes() const {
+    return _hasIncludes;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../base/base.h"
+
+// content hash of every .SUBCKT block of one spice file, comments and blank lines are ignored
+class SubcktIndex {
+    public:
+        struct Block {
+            uint64_t hash;
+            std::streamoff begin, end; // from ".SUBCKT" to the end of the ".ENDS" line
+        };
+    private:
+        std::string _fileName;
+        std::unordered_map<CELL_NAME, Block, StringCaseInsensitiveHash, StringCaseInsensitiveEqual> _blocks;
+        uint64_t _outsideHash{0};
+        std::string _outsideText; // .PARAM, .GLOBAL and top level lines, needed to re-parse single blocks
+        bool _hasIncludes{false}; // some outside line is .INCLUDE/.LIB with a file
+    public:
+        READ_STATE Build(const std::string& fileName); // NO_FILE or INPUT_CORRUPT if the file can't be read to its end
+        // changed includes added blocks; the outside lines are compared by the caller
+        void Diff(const SubcktIndex& old, std::vector<CELL_NAME>& changed, std::vector<CELL_NAME>& removed) const;
+        std::string ReadBlock(const CELL_NAME& name) const;
+
+        uint64_t GetOutsideHash() const;
+        const std::string& GetOutsideText() const;
+        size_t GetBlockNum() const;
+        bool HasIncludes() const;
+};